@@ -16,6 +16,7 @@ enum cicero_direction
 };
 typedef enum cicero_direction cicero_direction;
 
+// String form of the edges of a prefix, see cicero_callbacks::getedges
 struct cicero_edges
 {
     int  terminal;
@@ -24,11 +25,52 @@ struct cicero_edges
 typedef struct cicero_edges cicero_edges;
 
 // TODO: prefix these typedefs
-typedef void (*on_legal_move)(void *data, const char *word, int sq, int dir);
+// `score` is what cicero_make_move would return for the move. A single tile
+// that makes a word both ways is reported once, across, and the callback isn't
+// told about the down word: only the *_into generators give it, as the
+// `second` direction of a cicero_move_record.
+typedef void (*on_legal_move)(void *data, const char *word, int sq, int dir, int score);
 typedef cicero_edges (*prefix_edges)(void *data, const char *prefix);
 // non-zero indicates is valid word
 typedef int (*cicero_is_word)(const void *data, const char *word);
 
+// Lexicon cursor: a `cicero_node` is an opaque handle to a state in the
+// user's lexicon (e.g. a DAWG node). The move generator carries the handle
+// down the search, so each tile placed costs exactly one transition instead
+// of re-walking the whole prefix from the root.
+typedef int cicero_node;
+typedef cicero_node (*cicero_lexicon_root)(const void *data);
+// precondition: `letter` (0-25) is set in the edge mask of `node`
+typedef cicero_node (*cicero_lexicon_child)(const void *data, cicero_node node, int letter);
+// bit i is set if `node` has an out edge for letter 'A' + i. For a GADDAG
+// lexicon bit CICERO_GADDAG_SEP is the edge for the separator. Bit
+// CICERO_TERMINAL is set if the path to `node` spells a word, so each node
+// costs the move generators one call.
+typedef uint32_t (*cicero_lexicon_edges)(const void *data, cicero_node node);
+
+#define CICERO_GADDAG_SEP 26
+#define CICERO_TERMINAL   (1u << 31)
+
+// Hooks of a word: sets bit i of `front` if 'A' + i can be put in front of
+// `word` to make a word, and of `back` if it can be put behind it. `word` is
+// `len` letters A-Z. Returns 0 if it doesn't know `word`.
+typedef int (*cicero_word_hooks)(const void *data, const char *word, int len, uint32_t *front, uint32_t *back);
+
+// Memo of cross-check sets keyed by the tiles around the square: `frag` is
+// the `len` letters A-Z of the word through the square, with '.' at the
+// square. `lookup` returns 0 if it doesn't have `frag`.
+typedef int  (*cicero_xchk_lookup)(void *data, const char *frag, int len, uint32_t *xchk);
+typedef void (*cicero_xchk_store)(void *data, const char *frag, int len, uint32_t xchk);
+
+struct cicero_lexicon
+{
+    cicero_lexicon_root   root;
+    cicero_lexicon_child  child;
+    cicero_lexicon_edges  edges;
+    const void           *data;
+};
+typedef struct cicero_lexicon cicero_lexicon;
+
 enum cicero_legal_move_errnum
 {
     CICERO_LEGAL_MOVE                 =  0,
@@ -62,6 +104,50 @@ struct cicero_move2
 };
 typedef struct cicero_move2 cicero_move2;
 
+// Fixed-size record of a generated move, written to a cicero_move_sink
+// instead of calling `onlegal`.
+struct cicero_move_record
+{
+    char     tiles[16]; // A-Z of the word, '.' where the tile was already on the board
+    uint16_t blanks;    // bit i set if tiles[i] is played with a blank
+    uint16_t score;     // what cicero_make_move would return for the move
+    uint8_t  ntiles;    // # of tiles played from the rack
+    uint8_t  length;    // # of squares the word covers
+    uint8_t  square;    // square of the first letter of the word
+    uint8_t  direction;
+    uint8_t  second;    // direction of the other word made by a single tile, 0 if none
+};
+typedef struct cicero_move_record cicero_move_record;
+
+// Caller-owned buffer for the *_into move generators. Moves are generated in
+// the same order every time, so when there are more than `cap` of them the
+// caller can either grow `moves` to `total` and generate again, or page
+// through them by moving `skip` past the ones already read:
+//
+//     sink.skip = 0;
+//     do {
+//         cicero_generate_legal_moves_into(e, rack, &sink);
+//         // use sink.moves[0..sink.len)
+//         sink.skip += sink.len;
+//     } while (sink.skip < sink.total);
+struct cicero_move_sink
+{
+    cicero_move_record *moves;
+    int                 cap;
+    int                 len;   // # of records written by the last call
+    long                skip;  // # of moves to generate without writing them
+    long                total; // # of moves generated by the last call
+};
+typedef struct cicero_move_sink cicero_move_sink;
+
+// How cicero_generate_legal_moves_blanks_into designates blanks
+enum cicero_blanks
+{
+    CICERO_BLANKS_ALL,  // every designation
+    CICERO_BLANKS_BEST, // only the highest scoring one of each placement
+};
+typedef enum cicero_blanks cicero_blanks;
+
 struct cicero_move
 {
     const char      *tiles;    // A-Z=normal tiles, a-z=blank tiles
@@ -137,13 +223,42 @@ struct cicero_rack
 };
 typedef struct cicero_rack cicero_rack;
 
+// The same rack packed into 4 bits per tile, A-Z then the blank, with a mask of
+// the tiles it has so that it can be intersected with edge and cross-check
+// masks in one go. Holds up to 15 of each tile.
+struct cicero_packed_rack
+{
+    uint64_t counts[2]; // nibble i of counts[0] is tile i, of counts[1] tile 16 + i
+    uint32_t mask;      // bit i set iff there is at least one of tile i
+};
+typedef struct cicero_packed_rack cicero_packed_rack;
+
 // note: cicero will not touch the user data, however it is passed back to the user as non-const.
 struct cicero_callbacks
 {
     on_legal_move onlegal;
     const void   *onlegaldata;
+    // no longer used, words are looked up in `lexicon`. Kept so existing
+    // callbacks still build.
     prefix_edges  getedges;
     const void   *getedgesdata;
+    // used by move generation and cicero_legal_move
+    cicero_lexicon lexicon;
+    // optional, used by cicero_generate_legal_moves_gaddag and to keep the
+    // cross-checks in front of words incremental. Must be a GADDAG over the
+    // same words as `lexicon`, all zero if not used.
+    cicero_lexicon gaddag;
+    // optional, answers the cross-checks of squares at either end of a single
+    // word in one lookup instead of walking `lexicon`. Must agree with
+    // `lexicon`. NULL if not used.
+    cicero_word_hooks hooks;
+    const void       *hooksdata;
+    // optional, remembers the cross-check sets computed by walking `lexicon`
+    // so they can be shared between engines and games. Must only be used
+    // with one lexicon. NULL if not used.
+    cicero_xchk_lookup xchklookup;
+    cicero_xchk_store  xchkstore;
+    const void        *xchkdata;
 };
 typedef struct cicero_callbacks cicero_callbacks;
 
@@ -167,6 +282,12 @@ struct cicero_savepos
     uint32_t hchk[225]; // if playing horizontally, need to check hchk
     uint32_t vchk[225];
     uint64_t asqs[4];
+    cicero_node hfwd[225];
+    cicero_node vfwd[225];
+    cicero_node hrev[225];
+    cicero_node vrev[225];
+    uint16_t tvscr[225];
+    uint32_t tvchk[225];
 };
 typedef struct cicero_savepos cicero_savepos;
 
@@ -192,6 +313,25 @@ struct cicero
     // anchor squares bitmask
     uint64_t asqs[4];
 
+    // lexicon states of the runs of tiles the cross-checks are computed
+    // from, so that extending a run costs one transition instead of walking
+    // it again. hfwd is set at the last tile of each run that hchk is
+    // computed from: the `lexicon` state reached by the run. hrev is set at
+    // its first tile: the `gaddag` state reached by the run backwards, only
+    // if there is a `gaddag`. -1 if the run isn't part of any word.
+    cicero_node hfwd[225];
+    cicero_node vfwd[225];
+    cicero_node hrev[225];
+    cicero_node vrev[225];
+
+    // the board, vscr and vchk transposed so that each column is a row of 15
+    // squares in a row: tvals[sq] is the tile on column sq / 15, row sq % 15.
+    // Kept up to date with the above so vertical moves are generated the same
+    // way as horizontal ones, without striding 15 squares at a time.
+    char     tvals[225];
+    uint16_t tvscr[225];
+    uint32_t tvchk[225];
+
     cicero_callbacks cb;
     cicero_scoring   s;
 };
@@ -210,6 +350,10 @@ cicero_api void cicero_make_rack(cicero_rack *rack, const char *const tiles);
 // precondition: 'A' <= tile <= 'Z' or tile == ' '
 cicero_api void cicero_rack_add_tile(cicero_rack *rack, char tile);
 
+// Counts past the 15 a packed rack holds of each tile are packed as 15
+cicero_api cicero_packed_rack cicero_pack_rack(const cicero_rack *rack);
+cicero_api void cicero_unpack_rack(cicero_rack *rack, const cicero_packed_rack *packed);
+
 // note: no memory is allocated to intialize `cicero`
 // if `scoring` is NULL, then uses default official Scrabble values
 cicero_api void cicero_init_ex(cicero *e, cicero_callbacks callbacks,
@@ -234,9 +378,92 @@ cicero_api void cicero_undo_move(cicero *e, const cicero_savepos* sp,
 cicero_api void cicero_undo_move2(cicero *e, const cicero_savepos* sp,
         const cicero_move2 *move);
 
-// will call `onlegal` callback with all legal moves from `rack`
+// will call `onlegal` callback with all legal moves from `rack`. Each placement
+// comes once: a single tile that makes a word both ways is only generated
+// across, with VERT as its `second` direction in a cicero_move_record. The
+// callback has no `second`, so a callback user that wants the down move too
+// has to use cicero_generate_legal_moves_into instead.
 cicero_api void cicero_generate_legal_moves(const cicero *e, cicero_rack rack);
 
+// same as cicero_generate_legal_moves, but walks the `gaddag` lexicon
+// outward from each anchor (Gordon, "A Faster Scrabble Move Generation
+// Algorithm"). Generates exactly the same moves.
+cicero_api void cicero_generate_legal_moves_gaddag(const cicero *e, cicero_rack rack);
+
+// same as cicero_generate_legal_moves and cicero_generate_legal_moves_gaddag,
+// but writes the moves to `sink` instead of calling `onlegal`
+cicero_api void cicero_generate_legal_moves_into(const cicero *e, cicero_rack rack, cicero_move_sink *sink);
+cicero_api void cicero_generate_legal_moves_gaddag_into(const cicero *e, cicero_rack rack, cicero_move_sink *sink);
+
+// same as cicero_generate_legal_moves_into, but a blank is only placed where
+// the rack is out of the letter, as a wildcard, and which of the placed tiles
+// are blanks is worked out once a word is found, instead of trying a blank
+// for every letter on every square. With CICERO_BLANKS_ALL the moves are the
+// same, in another order. With CICERO_BLANKS_BEST each placement (the same
+// letters on the same squares) comes once, with the fewest blanks on the
+// squares where they cost the least: the first of its moves by
+// cicero_compare_move_records.
+cicero_api void cicero_generate_legal_moves_blanks_into(const cicero *e, cicero_rack rack, cicero_blanks blanks, cicero_move_sink *sink);
+
+// Move generation split into work items, one per anchor square and direction,
+// for callers that spread them over several threads. Writes the items to
+// `items`, which needs room for 2*225 of them, in the order the generators go
+// through them and returns how many there are.
+cicero_api int  cicero_move_items(const cicero *e, int *items);
+// same as cicero_generate_legal_moves_into for `items[0..n)` only, so the moves
+// of all the items in order are the moves of cicero_generate_legal_moves_into
+cicero_api void cicero_generate_items_into(const cicero *e, cicero_rack rack, const int *items, int n, cicero_move_sink *sink);
+
+// Move generation that stops once a sink is full and goes on from there on
+// the next call, for callers that want the moves a batch at a time without
+// generating them all up front, or again for every page:
+//
+//     cicero_movegen gen;
+//     cicero_movegen_start(&gen, e, rack);
+//     while (cicero_movegen_resume(&gen, &sink)) {
+//         // use sink.moves[0..sink.len)
+//     }
+//     // and the last sink.moves[0..sink.len)
+//
+// Only valid while the position it was started on doesn't change. The fields
+// are the generator's own.
+struct cicero_movegen
+{
+    const cicero      *e;
+    cicero_packed_rack rack;           // the tiles the frames haven't placed
+    int                items[2 * 225]; // see cicero_move_items
+    int                nitems;
+    int                item;           // the one being generated
+    int                top;            // its frame on top, -1 if not started
+    int                lsq;
+    int                limit;
+    int                len;            // of `word`
+    char               word[16];
+    uint64_t           stack[51];      // the search's frames, 17 of 24 bytes
+};
+typedef struct cicero_movegen cicero_movegen;
+
+// Starts generating the moves of cicero_generate_legal_moves_into from `rack`
+cicero_api void cicero_movegen_start(cicero_movegen *gen, const cicero *e, cicero_rack rack);
+// Writes the next moves, in the order of cicero_generate_legal_moves_into, to
+// `sink->moves` and sets `sink->len` and `sink->total` to how many. Stops once
+// there are `sink->cap` of them, which must be at least 1. `sink->skip` isn't
+// used. Returns non-zero if it stopped because the sink was full, in which
+// case the next call may still find no more moves.
+cicero_api int  cicero_movegen_resume(cicero_movegen *gen, cicero_move_sink *sink);
+
+// Writes the `k` highest scoring moves from `rack` to `moves`, best first, and
+// returns how many were written (fewer than `k` if there aren't that many).
+// Every move is generated into a heap of the best `k` so far, which saves
+// storing and sorting the rest but not generating them. Moves that score the
+// same are ordered by cicero_compare_move_records, so the result is always
+// the first `k` moves of cicero_generate_legal_moves_into sorted by it.
+cicero_api int cicero_find_top_k(const cicero *e, cicero_rack rack, cicero_move_record *moves, int k);
+
+// < 0 if `a` is the better move: higher score, then lower square, direction,
+// tiles and blanks. 0 only if they are the same move.
+cicero_api int cicero_compare_move_records(const cicero_move_record *a, const cicero_move_record *b);
+
 // XXX: DONE
 // TODO: maybe this function shouldn't be part of the public api since it is
 //       easy to mess up
@@ -265,6 +492,8 @@ cicero_api void cicero_load_position_ex(cicero* e, const cicero* position);
 
 cicero_api cicero_move2 cicero_make_move2(const cicero* e, const cicero_move* m);
 
+cicero_api cicero_move2 cicero_move_record_to_move2(const cicero_move_record* rec);
+
 // -------------------------------------------------------------------------- //
 
 #ifdef __cplusplus
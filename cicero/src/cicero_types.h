@@ -23,6 +23,10 @@ extern "C" {
 #endif
 
 #define internal static inline
+// For the lane kernels that are written once for both directions: inlined
+// where `dir` or `stride` is a constant, each call is compiled for that
+// direction, with constant strides and bounds and no branches on it.
+#define kernel static inline __attribute__((always_inline))
 
 #define ASIZE(x) (sizeof(x) / sizeof(x[0]))
 
@@ -76,6 +80,7 @@ static const char* const SQ[225] = {
 #define SQNAME(x) (((0 <= (x)) && ((x) < 225)) ? SQ[x] : "INV")
 
 static const u32  ANYTILE = 0xffffffffu;
+static const u32  LETTERS = (1u << 26) - 1;
 static const char EMPTY = 52;
 static const int  BLANK = 26;
 static const int  DIM = 15;
@@ -88,6 +93,8 @@ static const int  VERT = CICERO_VERT;
 // because a blank is worth 0. In the situation of forming a cross with
 // blank tile, still need to double count the placed tile's value.
 static const u16  NOCROSSTILES = 0xffffu;
+// state of a run of tiles that isn't part of any word
+static const cicero_node NONODE = -1;
 
 // Tile classes:
 typedef int  rack_tile; // 0-26 (26 == Blank)
@@ -95,7 +102,29 @@ typedef char eng_tile; // 0-25 = regular tile, 26-51 = blank tile
 typedef char ext_tile; // A-Z = regular tile, a-z = blank tile
 typedef char tile_num; // 0-25 ignoring blankness, i.e. A=a=0
 
-typedef int (*dimstart)(int sq);
+// cicero_packed_rack access, `tile` is a rack_tile
+internal int rack_count(const cicero_packed_rack* r, rack_tile tile)
+{
+    return (int)((r->counts[tile >> 4] >> (4 * (tile & 15))) & 15);
+}
+
+internal void rack_take(cicero_packed_rack* r, rack_tile tile)
+{
+    assert(rack_count(r, tile) > 0);
+    const int shift = 4 * (tile & 15);
+    u64* counts = &r->counts[tile >> 4];
+    *counts -= (u64)1 << shift;
+    if (((*counts >> shift) & 15) == 0) {
+        r->mask &= ~(1u << tile);
+    }
+}
+
+internal void rack_put(cicero_packed_rack* r, rack_tile tile)
+{
+    assert(rack_count(r, tile) < 15);
+    r->counts[tile >> 4] += (u64)1 << (4 * (tile & 15));
+    r->mask |= 1u << tile;
+}
 
 internal int getcol(int sq)   { return sq % DIM; }
 internal int getrow(int sq)   { return sq / DIM; }
@@ -103,6 +132,13 @@ internal int getdim(int dir, int sq) { return dir == HORZ ? getrow(sq) : getcol(
 // TODO: rename these; they are backwards
 internal int rowstart(int sq) { return getcol(sq); }
 internal int colstart(int sq) { return getrow(sq) * DIM; }
+// first square of the run of squares along `stride` through `sq`
+kernel int lanestart(int stride, int sq) { return stride == HORZ ? colstart(sq) : rowstart(sq); }
+// the square of the transposed board (see cicero::tvals) that is `sq` of the
+// board, and the other way round
+internal int transpose(int sq) { return getcol(sq) * DIM + getrow(sq); }
+// the board square of `sq` of the lane of direction `dir`
+internal int lane_square(int dir, int sq) { return dir == VERT ? transpose(sq) : sq; }
 internal int lsb(u64 x)       { return __builtin_ctzll(x); }
 internal u64 clearlsb(u64 x)  { return x & (x - 1); }
 
@@ -130,7 +166,7 @@ internal int getasq(const u64* asq, int sq)
     return (asq[m] & ((u64)(1ull << n))) != 0;
 }
 
-internal int flip_dir(int d)
+kernel int flip_dir(int d)
 {
     switch (d) {
         case CICERO_HORZ: return VERT;
@@ -208,7 +244,7 @@ internal int is_valid_non_blank_tile(char tile) {
 }
 
 // precondition: `root` is the left-most square trying to be played
-internal int findbeg(const char* vals, const int start, const int stop,
+kernel int findbeg(const char* vals, const int start, const int stop,
         const int stride, const int root)
 {
     int sq = root - stride;
@@ -221,7 +257,7 @@ internal int findbeg(const char* vals, const int start, const int stop,
 }
 
 // precondition: `root` should be the right-most square trying to be played
-internal int findend(const char* vals, const int start, const int stop,
+kernel int findend(const char* vals, const int start, const int stop,
         const int stride, const int root)
 {
     int sq = root + stride;
@@ -233,6 +269,143 @@ internal int findend(const char* vals, const int start, const int stop,
     return sq;
 }
 
+// Score of a move being generated, kept up to date as tiles are placed so the
+// move is scored when it is emitted instead of by playing it. Adds up the same
+// way as cicero_score_move2.
+struct runscore
+{
+    u16 main;   // main word, letter multipliers applied
+    u16 cross;  // cross words, multipliers applied
+    u8  mult;   // main word multiplier
+    u8  ntiles; // # of tiles placed
+};
+typedef struct runscore runscore;
+
+static const runscore NOSCORE = { .main=0, .cross=0, .mult=1, .ntiles=0 };
+
+// Letter and word multipliers by square, worked out once per generation
+// instead of from the four square tables for every tile placed. Moves are
+// generated along lanes of 15 squares with stride 1: the board's rows for
+// HORZ and the transposed board's (see cicero::tvals) for VERT, so the squares
+// here are those of the lane's board.
+struct scoretab
+{
+    const int  *letter_values;
+    const char *vals;  // vals or tvals, for the direction being generated
+    const u16  *xscr;  // hscr or tvscr
+    const u8   *lmult; // lmults[0] or lmults[1]
+    const u8   *wmult;
+    u8          lmults[2][225]; // HORZ, then VERT transposed
+    u8          wmults[2][225];
+};
+typedef struct scoretab scoretab;
+
+// point `t` at the lanes of direction `dir`
+internal void set_scoretab_dir(scoretab* t, const cicero* e, int dir)
+{
+    const int d = dir == HORZ ? 0 : 1;
+    t->vals  = d == 0 ? e->vals : e->tvals;
+    t->xscr  = d == 0 ? e->hscr : e->tvscr;
+    t->lmult = t->lmults[d];
+    t->wmult = t->wmults[d];
+}
+
+internal void init_scoretab(scoretab* t, const cicero* e)
+{
+    t->letter_values = e->s.letter_values;
+    for (int sq = 0; sq < DIM*DIM; ++sq) {
+        const u8 lmult = (u8)(e->s.double_letter_squares[sq] * e->s.triple_letter_squares[sq]);
+        const u8 wmult = (u8)(e->s.double_word_squares[sq] * e->s.triple_word_squares[sq]);
+        t->lmults[0][sq] = lmult;
+        t->wmults[0][sq] = wmult;
+        t->lmults[1][transpose(sq)] = lmult;
+        t->wmults[1][transpose(sq)] = wmult;
+    }
+    set_scoretab_dir(t, e, HORZ);
+}
+
+// `tile` is placed on `sq` from the rack
+internal runscore score_placed(const scoretab* t, runscore sc, int sq, eng_tile tile)
+{
+    const int letter_score = t->letter_values[tile] * t->lmult[sq];
+    sc.main += letter_score;
+    sc.mult *= t->wmult[sq];
+    if (t->xscr[sq] != NOCROSSTILES) {
+        sc.cross += (t->xscr[sq] + letter_score) * t->wmult[sq];
+    }
+    sc.ntiles++;
+    return sc;
+}
+
+// the tile already on `sq` is part of the main word
+internal runscore score_existing(const scoretab* t, runscore sc, int sq)
+{
+    sc.main += t->letter_values[t->vals[sq]];
+    return sc;
+}
+
+internal int score_total(const cicero* e, runscore sc)
+{
+    return sc.main * sc.mult + sc.cross + (sc.ntiles == 7 ? e->s.bingo_bonus : 0);
+}
+
+// A single tile that makes a word both ways is found from both directions, it
+// is only generated across. Returns the `second` direction of a move of
+// `ntiles` tiles through `anchor` in direction `dir`, or -1 if it is left to
+// the HORZ pass. `xscr` is the lane's cross-scores, there are cross tiles iff
+// the move makes a second word.
+internal int second_direction(const u16* xscr, int anchor, int dir, int ntiles)
+{
+    if (ntiles != 1 || xscr[anchor] == NOCROSSTILES) {
+        return 0;
+    }
+    return dir == HORZ ? VERT : -1;
+}
+
+// Fills `rec` with the move `word` (`len` letters, existing tiles included)
+// starting at the lane square `lsq` of direction `dir`, `vals` is the lane's
+// board (see scoretab)
+internal void make_record(cicero_move_record* rec, const char* vals, const char* word, int len, int lsq, int dir, int second, int score)
+{
+    rec->blanks = 0;
+    rec->ntiles = 0;
+    for (int k = 0, sq = lsq; k < len; ++k, ++sq) {
+        if (vals[sq] != EMPTY) {
+            rec->tiles[k] = '.';
+        } else if (CICERO_TILE_BLANK_A <= word[k] && word[k] <= CICERO_TILE_BLANK_Z) {
+            rec->tiles[k] = word[k] - CICERO_TILE_BLANK_A + CICERO_TILE_A;
+            rec->blanks |= (u16)(1u << k);
+            rec->ntiles++;
+        } else {
+            rec->tiles[k] = word[k];
+            rec->ntiles++;
+        }
+    }
+    rec->tiles[len]  = 0;
+    rec->score       = (u16)score;
+    rec->length      = (u8)len;
+    rec->square      = (u8)lane_square(dir, lsq);
+    rec->direction   = (u8)dir;
+    rec->second      = (u8)second;
+}
+
+// Writes the move to `sink` if it is past `sink->skip` and there is room.
+internal void sink_move(cicero_move_sink* sink, const char* vals, const char* word, int len, int lsq, int dir, int second, int score)
+{
+    const long i = sink->total++ - sink->skip;
+    if (i < 0 || i >= sink->cap) {
+        return;
+    }
+    make_record(&sink->moves[i], vals, word, len, lsq, dir, second, score);
+}
+
+// # of records written once the generation into `sink` is done
+internal int sink_len(const cicero_move_sink* sink)
+{
+    const long n = sink->total - sink->skip;
+    return n <= 0 ? 0 : n < sink->cap ? (int)n : sink->cap;
+}
+
 struct scoreresult_
 {
     int score;
@@ -240,7 +413,7 @@ struct scoreresult_
 };
 typedef struct scoreresult_ scoreresult;
 
-internal scoreresult scoreleft(const cicero* e, const int start,
+kernel scoreresult scoreleft(const cicero* e, const int start,
         const int stop, const int stride, const int root)
 {
     const char *vals = e->vals;
@@ -258,7 +431,7 @@ internal scoreresult scoreleft(const cicero* e, const int start,
     return result;
 }
 
-internal scoreresult scoreright(const cicero* e, const int start,
+kernel scoreresult scoreright(const cicero* e, const int start,
         const int stop, const int stride, const int root)
 {
     const char *vals = e->vals;
@@ -0,0 +1,176 @@
+#include "cicero_types.h"
+
+// GADDAG move generation from https://ericsink.com/downloads/faster-scrabble-gordon.pdf
+//
+// Every word is stored as REV(prefix) ^ suffix for each way of splitting it,
+// so generation can start at the anchor, walk left placing the reversed
+// prefix, then cross the separator and walk right placing the suffix.
+//
+// As with the DAWG generator, tiles are only placed to the left of the
+// anchor on squares that aren't anchors themselves so that every move is
+// generated from exactly one anchor (its left-most one).
+
+struct gstate
+{
+    const cicero         *e;
+    const cicero_lexicon *lex;
+    cicero_move_sink     *sink; // NULL to call `onlegal`
+    const u32            *xchk;
+    cicero_packed_rack   *rack;
+    int                   anchor; // lane squares, see scoretab
+    int                   start;
+    int                   stop;
+    int                   dir;
+    int                   beg; // word is buf[beg..end), anchor is buf[DIM-1]
+    int                   end;
+    char                  buf[32]; // 2*DIM + 1
+    scoretab              st;
+};
+typedef struct gstate gstate;
+
+internal void gen(gstate *gs, int sq, cicero_node node, runscore sc);
+
+internal int gempty(const gstate *gs, int sq)
+{
+    return sq < gs->start || sq >= gs->stop || gs->st.vals[sq] == EMPTY;
+}
+
+internal void record(gstate *gs, int lsq, runscore sc)
+{
+    const cicero *e = gs->e;
+    const int second = second_direction(gs->st.xscr, gs->anchor, gs->dir, sc.ntiles);
+    if (second < 0) {
+        return;
+    }
+    if (gs->sink) {
+        sink_move(gs->sink, gs->st.vals, &gs->buf[gs->beg], gs->end - gs->beg, lsq, gs->dir, second, score_total(e, sc));
+        return;
+    }
+    gs->buf[gs->end] = 0;
+    e->cb.onlegal((void*)e->cb.onlegaldata, &gs->buf[gs->beg], lane_square(gs->dir, lsq), gs->dir, score_total(e, sc));
+}
+
+// `node` and `sc` are the state after placing (or walking through) `ext` on `sq`
+internal void go_on(gstate *gs, int sq, char ext, cicero_node node, runscore sc)
+{
+    const cicero_lexicon *lex = gs->lex;
+    const int anchor = gs->anchor;
+    const u32 edges  = lex->edges(lex->data, node);
+    const int isterm = (edges & CICERO_TERMINAL) != 0;
+    if (sq <= anchor) { // moving left
+        const int lsq = sq - 1;
+        const int rsq = anchor + 1;
+        gs->buf[--gs->beg] = ext;
+        if (gempty(gs, lsq)) {
+            if (isterm && gempty(gs, rsq)) {
+                record(gs, sq, sc);
+            }
+            if (lsq >= gs->start && !getasq(gs->e->asqs, lane_square(gs->dir, lsq))) {
+                gen(gs, lsq, node, sc);
+            }
+            if (rsq < gs->stop && (edges & (1u << CICERO_GADDAG_SEP)) != 0) {
+                gen(gs, rsq, lex->child(lex->data, node, CICERO_GADDAG_SEP), sc);
+            }
+        } else {
+            gen(gs, lsq, node, sc);
+        }
+        gs->beg++;
+    } else { // moving right
+        const int rsq = sq + 1;
+        gs->buf[gs->end++] = ext;
+        if (gempty(gs, rsq)) {
+            if (isterm) {
+                record(gs, anchor - (DIM - 1 - gs->beg), sc);
+            }
+            if (rsq < gs->stop) {
+                gen(gs, rsq, node, sc);
+            }
+        } else {
+            gen(gs, rsq, node, sc);
+        }
+        gs->end--;
+    }
+}
+
+internal void gen(gstate *gs, int sq, cicero_node node, runscore sc)
+{
+    const cicero_lexicon *lex = gs->lex;
+    const char *vals = gs->st.vals;
+    cicero_packed_rack *rack = gs->rack;
+    const u32 edges = lex->edges(lex->data, node);
+    assert(gs->start <= sq && sq < gs->stop);
+
+    if (vals[sq] != EMPTY) {
+        const int tint = vals[sq] < BLANK ? vals[sq] : vals[sq] - BLANK; // ignore blankness
+        if ((edges & tilemask(tint)) != 0) {
+            go_on(gs, sq, to_ext(vals[sq]), lex->child(lex->data, node, tint), score_existing(&gs->st, sc, sq));
+        }
+        return;
+    }
+
+    const u32 letters = edges & gs->xchk[sq] & LETTERS; // meets cross-check?
+    for (u32 msk = letters & rack->mask; msk != 0; msk = clearlsb(msk)) { // have tile?
+        const int tint = lsb(msk);
+        rack_take(rack, tint);
+        go_on(gs, sq, 'A' + tint, lex->child(lex->data, node, tint), score_placed(&gs->st, sc, sq, tint));
+        rack_put(rack, tint);
+    }
+    if ((rack->mask & (1u << BLANK)) != 0) {
+        rack_take(rack, BLANK);
+        for (u32 msk = letters; msk != 0; msk = clearlsb(msk)) {
+            const int tint = lsb(msk);
+            go_on(gs, sq, 'a' + tint, lex->child(lex->data, node, tint), score_placed(&gs->st, sc, sq, BLANK + tint));
+        }
+        rack_put(rack, BLANK);
+    }
+}
+
+internal void generate(const cicero *e, cicero_rack rack, cicero_move_sink *sink)
+{
+    const int dirs[] = { HORZ, VERT };
+    const u64 *asqs = e->asqs;
+    const cicero_lexicon *lex = &e->cb.gaddag;
+    const cicero_node root = lex->root(lex->data);
+    cicero_packed_rack packed = cicero_pack_rack(&rack);
+    gstate gs;
+    gs.e    = e;
+    gs.lex  = lex;
+    gs.sink = sink;
+    gs.rack = &packed;
+    gs.beg  = DIM;
+    gs.end  = DIM;
+    init_scoretab(&gs.st, e);
+    for (int i = 0; i < 4; ++i) {
+        const int base = 64*i;
+        u64 msk = asqs[i];
+        while (msk > 0) {
+            const int anchor = base + lsb(msk);
+            for (int d = 0; d < ASIZE(dirs); ++d) {
+                const int dir   = dirs[d];
+                const int sq    = lane_square(dir, anchor);
+                const int start = colstart(sq);
+                gs.anchor = sq;
+                gs.start  = start;
+                gs.stop   = start + DIM;
+                gs.dir    = dir;
+                gs.xchk   = dir == HORZ ? e->hchk : e->tvchk;
+                set_scoretab_dir(&gs.st, e, dir);
+                gen(&gs, sq, root, NOSCORE);
+                assert(gs.beg == DIM && gs.end == DIM);
+            }
+            msk = clearlsb(msk);
+        }
+    }
+}
+
+void cicero_generate_legal_moves_gaddag(const cicero *e, cicero_rack rack)
+{
+    generate(e, rack, NULL);
+}
+
+void cicero_generate_legal_moves_gaddag_into(const cicero *e, cicero_rack rack, cicero_move_sink *sink)
+{
+    sink->total = 0;
+    generate(e, rack, sink);
+    sink->len = sink_len(sink);
+}
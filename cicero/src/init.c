@@ -11,6 +11,13 @@ void cicero_init_ex(cicero *e, cicero_callbacks callbacks,
     memset(e->vchk, 0xffu, sizeof(e->vchk));
     memset(e->hchk, 0xffu, sizeof(e->hchk));
     memset(e->asqs, 0x00u, sizeof(e->asqs));
+    memset(e->hfwd, 0xffu, sizeof(e->hfwd));
+    memset(e->vfwd, 0xffu, sizeof(e->vfwd));
+    memset(e->hrev, 0xffu, sizeof(e->hrev));
+    memset(e->vrev, 0xffu, sizeof(e->vrev));
+    memset(e->tvals, EMPTY, sizeof(e->tvals));
+    memset(e->tvscr, 0xffu, sizeof(e->tvscr));
+    memset(e->tvchk, 0xffu, sizeof(e->tvchk));
     setasq(e->asqs, SQ_H8);
     e->cb = callbacks;
 
@@ -88,3 +95,34 @@ cicero_move2 cicero_make_move2(const cicero* e, const cicero_move* m)
 
     return rv;
 }
+
+cicero_move2 cicero_move_record_to_move2(const cicero_move_record* rec)
+{
+    cicero_move2 rv;
+    memset(&rv.tiles[0], 0, sizeof(rv.tiles));
+    rv.square    = rec->square;
+    rv.direction = rec->direction;
+    for (int i = 0; i < rec->length; ++i) {
+        const char tile = rec->tiles[i];
+        rv.tiles[i] = (rec->blanks & (1u << i)) != 0 ? tile - CICERO_TILE_A + CICERO_TILE_BLANK_A : tile;
+    }
+    return rv;
+}
+
+int cicero_compare_move_records(const cicero_move_record* a, const cicero_move_record* b)
+{
+    if (a->score != b->score) {
+        return a->score > b->score ? -1 : 1;
+    }
+    if (a->square != b->square) {
+        return a->square < b->square ? -1 : 1;
+    }
+    if (a->direction != b->direction) {
+        return a->direction < b->direction ? -1 : 1;
+    }
+    const int cmp = strcmp(a->tiles, b->tiles);
+    if (cmp != 0) {
+        return cmp;
+    }
+    return a->blanks < b->blanks ? -1 : a->blanks > b->blanks ? 1 : 0;
+}
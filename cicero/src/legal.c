@@ -47,8 +47,6 @@ int cicero_legal_move_ex2(const cicero *e, const cicero_move2 *move,
     const int ntiles = count_tiles(move);
     const char *tiles = move->tiles;
     const int root = move->square;
-    const dimstart hstart = move->direction == CICERO_HORZ ? colstart : rowstart;
-    const dimstart vstart = move->direction == CICERO_HORZ ? rowstart : colstart;
 
     if (ntiles == 0) {
         return CICERO_NO_TILES_PLAYED;
@@ -60,7 +58,7 @@ int cicero_legal_move_ex2(const cicero *e, const cicero_move2 *move,
     int h8_played = board[SQ_H8] != EMPTY;
 
     { // Verify that all tiles that != '.' are empty, and the opposite
-        const int start  = hstart(root);
+        const int start  = lanestart(hstride, root);
         const int stride = hstride;
         const int stop   = start + DIM * stride;
         int sq = root;
@@ -83,7 +81,7 @@ int cicero_legal_move_ex2(const cicero *e, const cicero_move2 *move,
     char buffer[16];
     { // Verify root word
         char* p = &buffer[0];
-        const int start = hstart(root);
+        const int start = lanestart(hstride, root);
         const int stride = hstride;
         const int stop = start + DIM * stride;
         const int first = findbeg(board, start, stop, stride, root);
@@ -113,7 +111,7 @@ int cicero_legal_move_ex2(const cicero *e, const cicero_move2 *move,
 
     int root_sq = root;
     for (const char* tilep = tiles; *tilep; ++tilep, root_sq += hstride) {
-        const int start  = vstart(root_sq);
+        const int start  = lanestart(vstride, root_sq);
         const int stride = vstride;
         const int stop   = start + DIM * stride;
         const int first  = findbeg(board, start, stop, stride, root_sq);
@@ -144,13 +142,21 @@ int cicero_legal_move_ex2(const cicero *e, const cicero_move2 *move,
     return CICERO_LEGAL_MOVE;
 }
 
-internal int is_word_using_getedges(const void *data, const char *word)
+internal int is_word_using_lexicon(const void *data, const char *word)
 {
-    const cicero *e = data;
-    return e->cb.getedges((void*)e->cb.getedgesdata, word).terminal;
+    const cicero_lexicon *lex = &((const cicero*)data)->cb.lexicon;
+    cicero_node node = lex->root(lex->data);
+    for (const char *p = word; *p != '\0'; ++p) {
+        const int c = 'a' <= *p && *p <= 'z' ? *p - 'a' : *p - 'A'; // ignore blankness
+        if (c < 0 || c >= 26 || (lex->edges(lex->data, node) & tilemask(c)) == 0) {
+            return 0;
+        }
+        node = lex->child(lex->data, node, c);
+    }
+    return (lex->edges(lex->data, node) & CICERO_TERMINAL) != 0;
 }
 
 int cicero_legal_move(const cicero *e, const cicero_move *move)
 {
-    return cicero_legal_move_ex(e, move, &is_word_using_getedges, e);
+    return cicero_legal_move_ex(e, move, &is_word_using_lexicon, e);
 }
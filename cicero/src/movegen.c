@@ -37,12 +37,18 @@ void cicero_savepos_copy(cicero_savepos *sp, const cicero* e)
     memcpy(sp->hchk, e->hchk, sizeof(sp->hchk));
     memcpy(sp->vchk, e->vchk, sizeof(sp->vchk));
     memcpy(sp->asqs, e->asqs, sizeof(sp->asqs));
+    memcpy(sp->hfwd, e->hfwd, sizeof(sp->hfwd));
+    memcpy(sp->vfwd, e->vfwd, sizeof(sp->vfwd));
+    memcpy(sp->hrev, e->hrev, sizeof(sp->hrev));
+    memcpy(sp->vrev, e->vrev, sizeof(sp->vrev));
+    memcpy(sp->tvscr, e->tvscr, sizeof(sp->tvscr));
+    memcpy(sp->tvchk, e->tvchk, sizeof(sp->tvchk));
 #else
     memcpy(sp, e->vals, sizeof(*sp));
 #endif
 }
 
-internal int calc_cached_score(int start, int stop, int stride,
+kernel int calc_cached_score(int start, int stop, int stride,
         int root, const cicero *engine)
 {
     const char *vals = engine->vals;
@@ -84,6 +90,7 @@ void cicero_undo_move2(cicero *e, const cicero_savepos* sp,
         }
         assert(to_ext(board[sq]) == *tile);
         board[sq] = EMPTY;
+        e->tvals[transpose(sq)] = EMPTY;
     }
 
     // restore cached state
@@ -94,94 +101,188 @@ void cicero_undo_move2(cicero *e, const cicero_savepos* sp,
     memcpy(e->hchk, sp->hchk, sizeof(e->hchk));
     memcpy(e->vchk, sp->vchk, sizeof(e->vchk));
     memcpy(e->asqs, sp->asqs, sizeof(e->asqs));
+    memcpy(e->hfwd, sp->hfwd, sizeof(e->hfwd));
+    memcpy(e->vfwd, sp->vfwd, sizeof(e->vfwd));
+    memcpy(e->hrev, sp->hrev, sizeof(e->hrev));
+    memcpy(e->vrev, sp->vrev, sizeof(e->vrev));
+    memcpy(e->tvscr, sp->tvscr, sizeof(e->tvscr));
+    memcpy(e->tvchk, sp->tvchk, sizeof(e->tvchk));
 #else
     memcpy(e->hscr, sp->hscr, sizeof(*sp));
 #endif
 }
 
-internal cicero_edges getedges(const cicero* e, const char* root)
+// copies the square `sq` to the transposed board, see cicero::tvals
+internal void transpose_square(cicero* e, int sq)
 {
-    return e->cb.getedges((void*)e->cb.getedgesdata, root);
+    const int tsq = transpose(sq);
+    e->tvals[tsq] = e->vals[sq];
+    e->tvscr[tsq] = e->vscr[sq];
+    e->tvchk[tsq] = e->vchk[sq];
 }
 
-internal int build_word(const char* vals, const int start, const int stop, const int stride, const int root, string* word)
+internal u32 lexedges(const cicero_lexicon* lex, cicero_node node)
 {
-    assert(start <= root && root < stop);
-    assert(vals[root] == EMPTY);
-
-    // find left most square after `root`
-    int sq = root - stride;
-    while (sq >= start && vals[sq] != EMPTY) {
-        sq -= stride;
-    }
-    sq += stride;
-    assert(sq == root || vals[sq] != EMPTY);
-    assert((sq - stride) < start || vals[sq - stride] == EMPTY);
+    return lex->edges(lex->data, node);
+}
 
-    // fill in left part
-    word->len = 0;
-    for (; sq != root; sq += stride) {
-        assert(sq < stop);
-        assert(vals[sq] != EMPTY);
-        word->buf[word->len++] = to_ext(vals[sq]);
-    }
+internal cicero_node lexchild(const cicero_lexicon* lex, cicero_node node, int letter)
+{
+    assert((lexedges(lex, node) & tilemask(letter)) != 0);
+    return lex->child(lex->data, node, letter);
+}
 
-    // skip `root`
-    const int rootidx = word->len++;
-    assert(sq == root);
-    assert(vals[root] == EMPTY);
-#ifndef NDEBUG
-    word->buf[rootidx] = '?';
-#endif
-    sq += stride;
+internal int lexterm(const cicero_lexicon* lex, cicero_node node)
+{
+    return (lexedges(lex, node) & CICERO_TERMINAL) != 0;
+}
 
-    // fill in right part
-    for (; sq < stop && vals[sq] != EMPTY; sq += stride) {
-        word->buf[word->len++] = to_ext(vals[sq]);
+// Walks the tiles from `from` up to `to` (not included) along `stride`,
+// which is negative to walk backwards, starting at `node`. NONODE if they
+// fall off the lexicon.
+kernel cicero_node walk_run(const cicero_lexicon* lex, cicero_node node, const char* vals, int from, int to, int stride)
+{
+    for (int ss = from; ss != to && node != NONODE; ss += stride) {
+        const int tint = vals[ss] < BLANK ? vals[ss] : vals[ss] - BLANK; // ignore blankness
+        node = (lexedges(lex, node) & tilemask(tint)) != 0 ? lexchild(lex, node, tint) : NONODE;
     }
-    // TRACE("\tbuild_word(%s) stopping on %s (sq=%d stop=%d vals[sq]='%c')", SQNAME(root), SQNAME(sq), sq, stop, to_ext(vals[sq]));
-    word->buf[word->len] = '\0';
+    return node;
+}
 
-    return rootidx;
+// Updates the run states (see cicero::hfwd) of the run through `lo`..`hi`,
+// which were just filled. The part of the run before `lo` is carried on from
+// its forward state and the part after `hi` from its backward state, so only
+// the tiles between are walked.
+kernel void update_run(const cicero* e, cicero_node* fwd, cicero_node* rev, int start, int stop, int stride, int lo, int hi)
+{
+    const char* vals = e->vals;
+    const int beg  = findbeg(vals, start, stop, stride, lo);
+    const int last = findend(vals, start, stop, stride, hi);
+    const cicero_lexicon* lex = &e->cb.lexicon;
+    cicero_node node = beg != lo ? fwd[lo - stride] : lex->root(lex->data);
+    fwd[last] = walk_run(lex, node, vals, lo, last + stride, stride);
+    if (e->cb.gaddag.root) {
+        const cicero_lexicon* gad = &e->cb.gaddag;
+        node = last != hi ? rev[hi + stride] : gad->root(gad->data);
+        rev[beg] = walk_run(gad, node, vals, hi, beg - stride, -stride);
+    }
 }
 
-internal u32 calc_xchk(const cicero* e, char* word, int index)
+// Letters that lead from `node` through the tiles after `sq` up to `end` to
+// a word.
+kernel u32 walk_xchk(const cicero_lexicon* lex, cicero_node node, const char* vals, int sq, int end, int stride)
 {
     u32 xchk = 0;
-    for (char c = 'A'; c <= 'Z'; ++c) {
-        word[index] = c;
-        cicero_edges edges = getedges(e, word);
-        if (getedges(e, word).terminal) {
-            xchk |= tilemask(tilenum(c));
+    for (u32 msk = lexedges(lex, node) & ((1u << 26) - 1); msk != 0; msk = clearlsb(msk)) {
+        const int c = lsb(msk);
+        const cicero_node t = walk_run(lex, lexchild(lex, node, c), vals, sq + stride, end, stride);
+        if (t != NONODE && lexterm(lex, t)) {
+            xchk |= tilemask(c);
         }
     }
     return xchk;
 }
 
-int cicero_make_move(cicero *e, cicero_savepos *sp, const cicero_move *move)
+// Cross-check set of the empty square `sq`: the letters that form a word
+// with the tiles directly before and after it along `stride`. A square at
+// either end of a single word is looked up with the hooks callback first,
+// then the cross-check cache is tried. Failing both, the tiles are walked:
+// the ones before `sq` never are, their run's state is in `fwd`, and in
+// front of a run neither are the ones after it if there is a GADDAG to carry
+// on from the run's state in `rev`.
+kernel u32 calc_xchk(const cicero* e, const cicero_node* fwd, const cicero_node* rev, int start, int stop, int stride, int sq)
+{
+    const cicero_lexicon* lex = &e->cb.lexicon;
+    const char* vals = e->vals;
+    assert(vals[sq] == EMPTY);
+    const int beg = findbeg(vals, start, stop, stride, sq);
+    int end = sq + stride;
+    while (end < stop && vals[end] != EMPTY) {
+        end += stride;
+    }
+
+    // the tiles through `sq` with '.' at `sq`
+    char frag[DIM];
+    int len = 0;
+    u32 xchk;
+    if (e->cb.hooks || e->cb.xchklookup) {
+        int pos = 0;
+        for (int ss = beg; ss != end; ss += stride) {
+            if (ss == sq) {
+                pos = len;
+                frag[len++] = '.';
+            } else {
+                frag[len++] = 'A' + (vals[ss] < BLANK ? vals[ss] : vals[ss] - BLANK); // ignore blankness
+            }
+        }
+        if (e->cb.hooks && (pos == 0 || pos == len - 1)) {
+            u32 front, back;
+            if (e->cb.hooks(e->cb.hooksdata, pos == 0 ? frag + 1 : frag, len - 1, &front, &back)) {
+                return pos == 0 ? front : back;
+            }
+        }
+        if (e->cb.xchklookup && e->cb.xchklookup((void*)e->cb.xchkdata, frag, len, &xchk)) {
+            return xchk;
+        }
+    }
+    if (beg == sq && e->cb.gaddag.root) {
+        const cicero_node node = rev[sq + stride];
+        xchk = node != NONODE ? walk_xchk(&e->cb.gaddag, node, vals, sq, sq - stride, -stride) : 0;
+    } else {
+        const cicero_node node = beg != sq ? fwd[sq - stride] : lex->root(lex->data);
+        xchk = node != NONODE ? walk_xchk(lex, node, vals, sq, end, stride) : 0;
+    }
+    if (e->cb.xchkstore && len > 0) {
+        e->cb.xchkstore((void*)e->cb.xchkdata, frag, len, xchk);
+    }
+    return xchk;
+}
+
+// calc_xchk of the empty square `sq` with the run along a row, and along a
+// column, compiled once each
+internal u32 calc_xchk_row(const cicero* e, int sq)
+{
+    const int start = colstart(sq);
+    return calc_xchk(e, e->vfwd, e->vrev, start, start + DIM, HORZ, sq);
+}
+
+internal u32 calc_xchk_col(const cicero* e, int sq)
+{
+    const int start = rowstart(sq);
+    return calc_xchk(e, e->hfwd, e->hrev, start, start + DIM * DIM, VERT, sq);
+}
+
+// calc_xchk with the run along `stride`
+kernel u32 calc_xchk_along(const cicero* e, int stride, int sq)
+{
+    return stride == HORZ ? calc_xchk_row(e, sq) : calc_xchk_col(e, sq);
+}
+
+// cicero_make_move for a move along `dir`
+kernel int make_move_dir(cicero *e, cicero_savepos *sp, const cicero_move *move, int dir)
 {
     // TRACE("applying: %.*s", move->ntiles, move->tiles);
 
     // NOTE(peter): everything in this function is named as if computing
     // the horizontal cross-checks, but it is actually direction agnotistic.
-    char buf[17];
     const char *tiles   = move->tiles;
     const int  *squares = move->squares;
-    const int   dir     = move->direction;
     const int   ntiles  = move->ntiles;
-    const int   hstride = move->direction;
-    const int   vstride = flip_dir(move->direction);
+    const int   hstride = dir;
+    const int   vstride = flip_dir(dir);
     char *vals = e->vals;
     u32  *hchk = dir == HORZ ? e->hchk : e->vchk;
     u32  *vchk = dir == HORZ ? e->vchk : e->hchk;
     u16  *hscr = dir == HORZ ? e->hscr : e->vscr;
     u16  *vscr = dir == HORZ ? e->vscr : e->hscr;
     u64  *asqs = e->asqs;
-    dimstart horzstart = dir == HORZ ? &colstart : &rowstart;
-    dimstart vertstart = dir == HORZ ? &rowstart : &colstart;
+    cicero_node *hfwd = dir == HORZ ? e->hfwd : e->vfwd;
+    cicero_node *vfwd = dir == HORZ ? e->vfwd : e->hfwd;
+    cicero_node *hrev = dir == HORZ ? e->hrev : e->vrev;
+    cicero_node *vrev = dir == HORZ ? e->vrev : e->hrev;
     const int lsq   = squares[0];          // left-most square
     const int rsq   = squares[ntiles - 1]; // right-most square
-    const int hstart = horzstart(lsq);
+    const int hstart = lanestart(hstride, lsq);
     const int hstop  = hstart + hstride * DIM;
     assert(ntiles > 0);
     assert(squares != NULL);
@@ -195,12 +296,13 @@ int cicero_make_move(cicero *e, cicero_savepos *sp, const cicero_move *move)
         const int root   = squares[tidx];
         const char tile  = tiles[tidx];
         const char teng  = to_eng(tile);
-        const int start  = vertstart(root);
+        const int start  = lanestart(stride, root);
         const int stop   = start + DIM * stride;
         const int before = findbeg(vals, start, stop, stride, root) - stride;
         const int after  = findend(vals, start, stop, stride, root) + stride;
         assert(vals[root] == EMPTY);
         vals[root] = teng;
+        update_run(e, hfwd, hrev, start, stop, stride, root, root);
 #ifdef FOR_TEST_COMPLIANCE
         hchk[root] = 0;
         vchk[root] = 0;
@@ -208,23 +310,19 @@ int cicero_make_move(cicero *e, cicero_savepos *sp, const cicero_move *move)
         if (before >= start) {
             assert(getdim(stride, before) == getdim(stride, root));
             assert(vals[before] == EMPTY);
-            string word;
-            const int idx = build_word(vals, start, stop, stride, before, &word);
-            // TRACE("B HORZ XCHK[%s]: word='%s'", SQNAME(before), word.buf);
-            hchk[before]  = calc_xchk(e, word.buf, idx);
+            hchk[before]  = calc_xchk_along(e, stride, before);
             hscr[before]  = calc_cached_score(start, stop, stride, before, e);
             setasq(asqs, before);
+            transpose_square(e, before);
         }
 
         if (after < stop) {
             assert(getdim(stride, after) == getdim(stride, root));
             assert(vals[after] == EMPTY);
-            string word;
-            const int idx = build_word(vals, start, stop, stride, after, &word);
-            // TRACE("A HORZ XCHK[%s]: word='%s'", SQNAME(after), word.buf);
-            hchk[after]   = calc_xchk(e, word.buf, idx);
+            hchk[after]   = calc_xchk_along(e, stride, after);
             hscr[after]   = calc_cached_score(start, stop, stride, after, e);
             setasq(asqs, after);
+            transpose_square(e, after);
         }
 
         assert(vals[root] != EMPTY);
@@ -238,27 +336,24 @@ int cicero_make_move(cicero *e, cicero_savepos *sp, const cicero_move *move)
         const int before = findbeg(vals, start, stop, stride, lsq) - stride;
         const int after  = findend(vals, start, stop, stride, rsq) + stride;
         assert(getdim(stride, lsq) == getdim(stride, rsq)); // move must be on exactly 1 row or col
+        update_run(e, vfwd, vrev, start, stop, stride, lsq, rsq);
         if (before >= start) {
             assert(vals[before] == EMPTY);
             assert(getdim(stride, before) == getdim(stride, lsq));
             assert(getdim(stride, before) == getdim(stride, rsq));
-            string word;
-            const int idx = build_word(vals, start, stop, stride, before, &word);
-            // TRACE("B VERT XCHK[%s]: word='%s'", SQNAME(before), word.buf);
-            vchk[before]  = calc_xchk(e, word.buf, idx);
+            vchk[before]  = calc_xchk_along(e, stride, before);
             vscr[before]  = calc_cached_score(start, stop, stride, before, e);
             setasq(asqs, before);
+            transpose_square(e, before);
         }
         if (after < stop) {
             assert(vals[after] == EMPTY);
             assert(getdim(stride, after) == getdim(stride, lsq));
             assert(getdim(stride, after) == getdim(stride, rsq));
-            string word;
-            const int idx = build_word(vals, start, stop, stride, after, &word);
-            // TRACE("A VERT XCHK[%s]: word='%s'", SQNAME(after), word.buf);
-            vchk[after]   = calc_xchk(e, word.buf, idx);
+            vchk[after]   = calc_xchk_along(e, stride, after);
             vscr[after]   = calc_cached_score(start, stop, stride, after, e);
             setasq(asqs, after);
+            transpose_square(e, after);
         }
     }
 
@@ -271,10 +366,19 @@ int cicero_make_move(cicero *e, cicero_savepos *sp, const cicero_move *move)
         vscr[root] = 0xffffu;
     }
 #endif
+    for (int tidx = 0; tidx < ntiles; ++tidx) {
+        transpose_square(e, squares[tidx]);
+    }
 
     return score;
 }
 
+int cicero_make_move(cicero *e, cicero_savepos *sp, const cicero_move *move)
+{
+    assert(move->direction == HORZ || move->direction == VERT);
+    return move->direction == HORZ ? make_move_dir(e, sp, move, HORZ) : make_move_dir(e, sp, move, VERT);
+}
+
 // TODO: add safety checks that the position makes some sense
 void cicero_load_position(cicero* e, char board[225])
 {
@@ -298,6 +402,26 @@ void cicero_load_position(cicero* e, char board[225])
     memset(vchk, 0xffffffffu, sizeof(e->vchk));
     memset(hchk, 0xffffffffu, sizeof(e->hchk));
     memset(asqs, 0x00000000u, sizeof(e->asqs));
+
+    // run states from the first tile of each run
+    for (int sq = 0; sq < 225; ++sq) {
+        if (vals[sq] == EMPTY) {
+            continue;
+        }
+        const int vstride = DIM;
+        const int vstart  = rowstart(sq);
+        const int vstop   = vstart + vstride*DIM;
+        if (sq - vstride < vstart || vals[sq - vstride] == EMPTY) {
+            update_run(e, e->hfwd, e->hrev, vstart, vstop, vstride, sq, findend(vals, vstart, vstop, vstride, sq));
+        }
+        const int hstride = 1;
+        const int hstart  = colstart(sq);
+        const int hstop   = hstart + hstride*DIM;
+        if (sq - hstride < hstart || vals[sq - hstride] == EMPTY) {
+            update_run(e, e->vfwd, e->vrev, hstart, hstop, hstride, sq, findend(vals, hstart, hstop, hstride, sq));
+        }
+    }
+
     for (int sq = 0; sq < 225; ++sq) {
         // TODO: combine these if cases
 
@@ -337,81 +461,24 @@ void cicero_load_position(cicero* e, char board[225])
             vscr[sq] = tiles != 0 ? xscore : 0xffff;
         }
 
-        string word;
-        word.len = 0;
-        int neighbors = 0;
-
-        // horizontal cross-check
+        // cross-checks are only set if touching other tiles -- this just
+        // makes the first move easier to check if all squares are initially
+        // set to 0xffffffffu
         if (vals[sq] == EMPTY) {
-            word.len = 0;
             const int vstride = DIM;
             const int vstart  = rowstart(sq);
             const int vstop   = vstart + vstride*DIM;
-            const int beg = findbeg(vals, vstart, vstop, vstride, sq);
-            int ss = beg;
-            for (; vals[ss] != EMPTY; ss += vstride) {
-                assert(ss < sq);
-                word.buf[word.len++] = to_ext(vals[ss]);
-            }
-            // skip `sq`
-            const int index = word.len++;
-            ss += vstride;
-            for (; ss < vstop && vals[ss] != EMPTY; ss += vstride) {
-                word.buf[word.len++] = to_ext(vals[ss]);
-            }
-
-
-            // only set if touching other tiles -- this just makes the first
-            // move easier to check if all squares are initially set to
-            // 0xffffffffu
-            if (word.len != 1) {
-                word.buf[word.len] = '\0';
-                u32 xchk = 0;
-                for (char c = 'A'; c <= 'Z'; ++c) {
-                    word.buf[index] = c;
-                    cicero_edges edges = e->cb.getedges((void*)e->cb.getedgesdata, word.buf);
-                    if (edges.terminal) {
-                        xchk |= tilemask(tilenum(c));
-                    }
-                }
-                hchk[sq] = xchk;
+            if ((sq - vstride >= vstart && vals[sq - vstride] != EMPTY) ||
+                (sq + vstride <  vstop  && vals[sq + vstride] != EMPTY)) {
+                hchk[sq] = calc_xchk_col(e, sq);
                 setasq(asqs, sq);
             }
-        }
-
-        // vertical cross-check
-        if (vals[sq] == EMPTY) {
-            word.len = 0;
             const int hstride = 1;
             const int hstart  = colstart(sq);
             const int hstop   = hstart + hstride*DIM;
-            const int beg = findbeg(vals, hstart, hstop, hstride, sq);
-            int ss = beg;
-            for (; vals[ss] != EMPTY; ss += hstride) {
-                assert(ss < sq);
-                word.buf[word.len++] = to_ext(vals[ss]);
-            }
-            // skip `sq`
-            const int index = word.len++;
-            ss += hstride;
-            for (; ss < hstop && vals[ss] != EMPTY; ss += hstride) {
-                word.buf[word.len++] = to_ext(vals[ss]);
-            }
-
-            // only set if touching other tiles -- this just makes the first
-            // move easier to check if all squares are initially set to
-            // 0xffffffffu
-            if (word.len != 1) {
-                word.buf[word.len] = '\0';
-                u32 xchk = 0;
-                for (char c = 'A'; c <= 'Z'; ++c) {
-                    word.buf[index] = c;
-                    cicero_edges edges = e->cb.getedges((void*)e->cb.getedgesdata, word.buf);
-                    if (edges.terminal) {
-                        xchk |= tilemask(tilenum(c));
-                    }
-                }
-                vchk[sq] = xchk;
+            if ((sq - hstride >= hstart && vals[sq - hstride] != EMPTY) ||
+                (sq + hstride <  hstop  && vals[sq + hstride] != EMPTY)) {
+                vchk[sq] = calc_xchk_row(e, sq);
                 setasq(asqs, sq);
             }
         }
@@ -426,6 +493,10 @@ void cicero_load_position(cicero* e, char board[225])
     if (asqs[0] == 0 && asqs[1] == 0 && asqs[2] == 0 && asqs[3] == 0) {
         setasq(asqs, SQ_H8);
     }
+
+    for (int sq = 0; sq < 225; ++sq) {
+        transpose_square(e, sq);
+    }
 }
 
 void cicero_load_position_ex(cicero* e, const cicero* position)
@@ -449,241 +520,810 @@ void cicero_load_position_ex(cicero* e, const cicero* position)
 //
 // Additional Notes:
 //   + Everything in this file is specified from the standpoint of generating horizontal
-//     moves. For vertical moves, we can just conceptually rotate the board.
+//     moves. Vertical moves are generated the same way on the transposed board (see
+//     cicero::tvals), so squares are those of the lane's board and go up by 1 along it.
+
+// The best moves found so far by cicero_find_top_k, as a heap with the worst
+// of them at heap[0]
+struct topk
+{
+    cicero_move_record *heap;
+    int                 cap;
+    int                 len;
+};
+typedef struct topk topk;
 
 struct state
 {
-    const cicero *e;
-    const u32    *xchk;
-    cicero_rack  *r;
-    int           anchor;
-    int           start;
-    int           stride;
-    int           stop;
+    const cicero     *e;
+    const u32        *xchk;
+    scoretab          st;
+    cicero_packed_rack *r;
+    cicero_move_sink *sink; // NULL to call `onlegal`
+    topk             *top;  // NULL unless only the best moves are wanted
+    int               suspend; // search stops once `sink` is full, see cicero_movegen
+    int               anchor; // lane squares, see scoretab
+    int               start;
+    int               stop;
+    int               dir;
+    int               left_placed; // the left part is played from the rack, and
+                                   // is only scored once a move is emitted
+    // a cicero_blanks mode if the tiles are placed as wildcards: the letter
+    // if the rack has one left, else a blank, with the blanks designated once
+    // a move is emitted. -1 to try a blank for every letter as it is placed.
+    int               blanks;
+    cicero_packed_rack rack0;      // ... and the rack to begin with, to designate them from
 };
 typedef struct state state;
 
-internal int range_contains_square(int start, int stride, int length, int sq)
+// score a move has to reach to be one of the best moves
+internal int topk_min(const topk* top)
 {
-    for (int i = 0; i < length; ++i) {
-        if (start + stride * i == sq) {
-            return 1;
+    return top->len < top->cap ? 0 : top->heap[0].score;
+}
+
+internal void topk_push(topk* top, const char* vals, const char* word, int len, int lsq, int dir, int second, int score)
+{
+    if (score < topk_min(top)) {
+        return;
+    }
+    cicero_move_record rec;
+    make_record(&rec, vals, word, len, lsq, dir, second, score);
+    cicero_move_record* heap = top->heap;
+    int i;
+    if (top->len < top->cap) {
+        for (i = top->len++; i > 0 && cicero_compare_move_records(&heap[(i - 1) / 2], &rec) < 0; i = (i - 1) / 2) {
+            heap[i] = heap[(i - 1) / 2];
+        }
+    } else {
+        if (cicero_compare_move_records(&rec, &heap[0]) > 0) {
+            return; // worse than all of them
+        }
+        for (i = 0; 2 * i + 1 < top->len; ) {
+            int child = 2 * i + 1;
+            if (child + 1 < top->len && cicero_compare_move_records(&heap[child + 1], &heap[child]) > 0) {
+                ++child;
+            }
+            if (cicero_compare_move_records(&heap[child], &rec) < 0) {
+                break;
+            }
+            heap[i] = heap[child];
+            i = child;
         }
     }
-    return 0;
+    heap[i] = rec;
 }
 
-internal void revbuf(char* buf, int length)
+// The tiles of a left part played from the rack only land on their squares
+// once it stops growing, so they are scored when the move is emitted.
+internal runscore score_left_part(const state* ss, int lsq, const string* word, runscore sc)
 {
-    char* p1 = &buf[0];
-    char* p2 = &buf[length - 1];
-    while (p1 < p2) {
-        char t = *p1;
-        *p1 = *p2;
-        *p2 = t;
-        ++p1;
-        --p2;
+    for (int i = 0, sq = lsq; sq < ss->anchor; ++i, ++sq) {
+        const char c = word->buf[i];
+        const eng_tile tile = c >= 'a' ? BLANK + (c - 'a') : c - 'A';
+        sc = score_placed(&ss->st, sc, sq, tile);
     }
+    return sc;
 }
 
-internal void extend_right(const state* ss, int lsq, int sq, string* word, int right_part_length)
+// hands the move to the best moves, the sink or `onlegal`
+internal void emit_move(const state* ss, int lsq, string* word, int second, int score)
 {
-    word->buf[word->len] = 0;
     const cicero* e = ss->e;
-    int* rack = ss->r->tiles;
-    const cicero_edges edges_ = e->cb.getedges((void*)e->cb.getedgesdata, word->buf);
-    const char* edges = edges_.edges;
-    const int terminal = edges_.terminal;
-    const char* vals = e->vals;
+    if (ss->top) {
+        topk_push(ss->top, ss->st.vals, word->buf, word->len, lsq, ss->dir, second, score);
+    } else if (ss->sink) {
+        sink_move(ss->sink, ss->st.vals, word->buf, word->len, lsq, ss->dir, second, score);
+    } else {
+        word->buf[word->len] = 0;
+        e->cb.onlegal((void*)e->cb.onlegaldata, word->buf, lane_square(ss->dir, lsq), ss->dir, score);
+    }
+}
+
+// The tiles a move placed as wildcards, see state::blanks
+struct wildcards
+{
+    int n;
+    int pos[15];  // in the word
+    int loss[15]; // points lost if the tile is a blank
+};
+typedef struct wildcards wildcards;
+
+// Emits the move for every way of making the tiles from `i` on real tiles
+// (`reals` left of each letter) or blanks (`blanks` left)
+internal void designate_all(const state* ss, int lsq, string* word, int second, int score,
+        const wildcards* w, int i, int* reals, int blanks)
+{
+    if (i == w->n) {
+        emit_move(ss, lsq, word, second, score);
+        return;
+    }
+    const int k = w->pos[i];
+    const int tint = word->buf[k] - 'A';
+    if (reals[tint] > 0) {
+        --reals[tint];
+        designate_all(ss, lsq, word, second, score, w, i + 1, reals, blanks);
+        ++reals[tint];
+    }
+    if (blanks > 0) {
+        word->buf[k] = 'a' + tint;
+        designate_all(ss, lsq, word, second, score - w->loss[i], w, i + 1, reals, blanks - 1);
+        word->buf[k] = 'A' + tint;
+    }
+}
+
+// Emits the move `word` placed with wildcards and scored `sc` as if they were
+// all real tiles, with its blanks designated as asked for by ss->blanks. A
+// blank costs the letter's score on its square in the main word, and in the
+// cross word if there is one, so each one costs the same whatever the others
+// are: the best designation puts the blanks each letter needs on its cheapest
+// squares, the first ones if they cost the same.
+internal void emit_wildcards(const state* ss, int lsq, string* word, int second, runscore sc)
+{
+    const scoretab* t = &ss->st;
+    const int score = score_total(ss->e, sc);
+    if (ss->blanks == CICERO_BLANKS_BEST && rack_count(ss->r, BLANK) == rack_count(&ss->rack0, BLANK)) {
+        emit_move(ss, lsq, word, second, score); // no blanks needed
+        return;
+    }
+    wildcards w;
+    w.n = 0;
+    int need[26] = {0}; // # of blanks each letter needs
+    for (int k = 0, sq = lsq; k < word->len; ++k, ++sq) {
+        if (t->vals[sq] != EMPTY) {
+            continue;
+        }
+        const int tint = word->buf[k] - 'A';
+        const int wmult = sc.mult + (t->xscr[sq] != NOCROSSTILES ? t->wmult[sq] : 0);
+        w.pos[w.n]  = k;
+        w.loss[w.n] = t->letter_values[tint] * t->lmult[sq] * wmult;
+        ++w.n;
+        ++need[tint];
+    }
+    if (ss->blanks == CICERO_BLANKS_ALL) {
+        int reals[26];
+        for (int c = 0; c < 26; ++c) {
+            reals[c] = rack_count(&ss->rack0, c);
+        }
+        designate_all(ss, lsq, word, second, score, &w, 0, reals, rack_count(&ss->rack0, BLANK));
+        return;
+    }
+
+    for (int c = 0; c < 26; ++c) {
+        need[c] = need[c] > rack_count(&ss->rack0, c) ? need[c] - rack_count(&ss->rack0, c) : 0;
+    }
+    u32 chosen = 0;
+    int lost = 0;
+    for (int i = 0; i < w.n; ++i) {
+        const char tile = word->buf[w.pos[i]];
+        int cheaper = 0; // the letter's tiles that cost less, or as much and come first
+        for (int j = 0; j < w.n; ++j) {
+            if (j != i && word->buf[w.pos[j]] == tile && (w.loss[j] < w.loss[i] || (w.loss[j] == w.loss[i] && j < i))) {
+                ++cheaper;
+            }
+        }
+        if (cheaper < need[tile - 'A']) {
+            chosen |= 1u << i;
+            lost += w.loss[i];
+        }
+    }
+    for (u32 msk = chosen; msk != 0; msk = clearlsb(msk)) {
+        word->buf[w.pos[lsb(msk)]] += 'a' - 'A';
+    }
+    emit_move(ss, lsq, word, second, score - lost);
+    for (u32 msk = chosen; msk != 0; msk = clearlsb(msk)) {
+        word->buf[w.pos[lsb(msk)]] -= 'a' - 'A';
+    }
+}
+
+internal void extend_right(const state* ss, int lsq, int sq, cicero_node node, string* word, runscore sc)
+{
+    const cicero* e = ss->e;
+    const cicero_lexicon* lex = &e->cb.lexicon;
+    cicero_packed_rack* rack = ss->r;
+    const char* vals = ss->st.vals;
     const u32* xchk  = ss->xchk;
     const int anchor = ss->anchor;
-    const int start  = ss->start;
-    const int stride = ss->stride;
+    const int dir    = ss->dir;
     const int stop   = ss->stop;
-    const int nextsq = sq + stride;
-    const int rsq    = sq - stride;
+    const int nextsq = sq + 1;
 
     if (sq >= stop || vals[sq] == EMPTY) {
-        if (/*right_part_length > 0*/ sq > anchor && terminal) {
-            assert(word->buf[word->len] == 0);
-            e->cb.onlegal((void*)e->cb.onlegaldata, word->buf, lsq, ss->stride);
+        const u32 edges = lexedges(lex, node);
+        // a left part from the rack isn't counted in `sc` until it is scored
+        const int ntiles = sc.ntiles + (ss->left_placed ? anchor - lsq : 0);
+        const int second = second_direction(ss->st.xscr, anchor, dir, ntiles);
+        if (sq > anchor && second >= 0 && (edges & CICERO_TERMINAL) != 0) {
+            const runscore total = ss->left_placed ? score_left_part(ss, lsq, word, sc) : sc;
+            if (ss->blanks >= 0) {
+                emit_wildcards(ss, lsq, word, second, total);
+            } else {
+                emit_move(ss, lsq, word, second, score_total(e, total));
+            }
         }
         if (sq >= stop) { // hit end of board
             return;
         }
-        for (const char* tile = edges; *tile != 0; ++tile) {
-            const char tint = tilenum(*tile);
-            if (rack[tint] == 0) {               // have tile?
-                continue;
-            }
-            if ((xchk[sq] & tilemask(tint)) == 0) {  // meets cross-check?
-                continue;
+        const u32 letters = edges & xchk[sq] & LETTERS; // meets cross-check?
+        if (ss->blanks >= 0) {
+            const u32 wild = (rack->mask & (1u << BLANK)) != 0 ? letters : letters & rack->mask;
+            for (u32 msk = wild; msk != 0; msk = clearlsb(msk)) {
+                const int tint = lsb(msk);
+                const rack_tile tile = (rack->mask & (1u << tint)) != 0 ? tint : BLANK;
+                rack_take(rack, tile);
+                word->buf[word->len++] = 'A' + tint;
+                assert(word->len <= DIM);
+                extend_right(ss, lsq, nextsq, lexchild(lex, node, tint), word, score_placed(&ss->st, sc, sq, tint));
+                word->len--;
+                rack_put(rack, tile);
             }
-            rack[tint]--;
-            word->buf[word->len++] = *tile; // TODO: hoist out of loop
-            word->buf[word->len]   = 0;     // TODO: hoist out of loop
+            return;
+        }
+        for (u32 msk = letters & rack->mask; msk != 0; msk = clearlsb(msk)) { // have tile?
+            const int tint = lsb(msk);
+            rack_take(rack, tint);
+            word->buf[word->len++] = 'A' + tint;
             assert(word->len <= DIM);
-            extend_right(ss, lsq, nextsq, word, right_part_length + 1);
-            word->len--;                    // TODO: hoist out of loop
-            word->buf[word->len] = 0;       // TODO: hoist out of loop
-            rack[tint]++;
+            extend_right(ss, lsq, nextsq, lexchild(lex, node, tint), word, score_placed(&ss->st, sc, sq, tint));
+            word->len--;
+            rack_put(rack, tint);
         }
         // NOTE: need to run a second time with blanks so I check both path of using
         //       the blank vs using the actual tile if I have it
-        if (rack[BLANK] > 0) {
-            for (const char* tile = edges; *tile != 0; ++tile) {
-                const char tint = tilenum(*tile);
-                if ((xchk[sq] & tilemask(tint)) == 0) {  // meets cross-check?
-                    continue;
-                }
-                rack[BLANK]--;                  // TODO: hoist out of loop
-                word->buf[word->len++] = 'a' + (*tile - 'A'); // TODO: hoist len incr out of loop
-                word->buf[word->len]   = 0;     // TODO: hoist out of loop
+        if ((rack->mask & (1u << BLANK)) != 0) {
+            rack_take(rack, BLANK);
+            for (u32 msk = letters; msk != 0; msk = clearlsb(msk)) {
+                const int tint = lsb(msk);
+                word->buf[word->len++] = 'a' + tint;
                 assert(word->len <= DIM);
-                extend_right(ss, lsq, nextsq, word, right_part_length + 1);
-                word->len--;                    // TODO: hoist out of loop
-                word->buf[word->len] = 0;       // TODO: hoist out of loop
-                rack[BLANK]++;                  // TODO: hoist out of loop
+                extend_right(ss, lsq, nextsq, lexchild(lex, node, tint), word, score_placed(&ss->st, sc, sq, BLANK + tint));
+                word->len--;
             }
+            rack_put(rack, BLANK);
         }
     } else {
         assert(vals[sq] != EMPTY);
-        const char tile = vals[sq] < BLANK ? vals[sq] + 'A' : vals[sq] - BLANK + 'A'; // force to be in range [A..Z]
-        assert('A' <= tile && tile <= 'Z');
-        if (strchr(edges, tile) != NULL) {
+        const int tint = vals[sq] < BLANK ? vals[sq] : vals[sq] - BLANK; // ignore blankness
+        if ((lexedges(lex, node) & tilemask(tint)) != 0) {
             word->buf[word->len++] = to_ext(vals[sq]);
-            word->buf[word->len]   = 0;
-            extend_right(ss, lsq, nextsq, word, right_part_length);
+            extend_right(ss, lsq, nextsq, lexchild(lex, node, tint), word, score_existing(&ss->st, sc, sq));
             word->len--;
         }
     }
 }
 
-// TODO: remove `sq` parameter, can calculate it from sq = anchor - strlen(word->buf) - 1 (see line 278 assertion below)
-internal void left_part(const state* ss, int sq, int limit, string* word)
+// TODO: remove `sq` parameter, can calculate it from sq = anchor - word->len - 1 (see assertion below)
+internal void left_part(const state* ss, int sq, int limit, cicero_node node, string* word)
 {
-    word->buf[word->len] = 0; // TEMP?
-
     const cicero *e = ss->e;
-    const cicero_edges edges_   = e->cb.getedges((void*)e->cb.getedgesdata, word->buf);
-    const char *edges    = edges_.edges;
-    const int   terminal = edges_.terminal;
+    const cicero_lexicon* lex = &e->cb.lexicon;
     const u32 *xchk   = ss->xchk;
     const int  anchor = ss->anchor;
     const int  start  = ss->start;
-    const int  stride = ss->stride;
-    const int  stop   = ss->stop;
-    int       *rack   = ss->r->tiles;
-    assert((((anchor - sq) / stride) - 1) == strlen(word->buf));
+    cicero_packed_rack *rack = ss->r;
+    assert(anchor - sq - 1 == word->len);
 
-    extend_right(ss, sq + stride, anchor, word, /*right_part_length*/0);
+    extend_right(ss, sq + 1, anchor, node, word, NOSCORE);
 
     if (limit == 0) {
         return;
     }
-    assert(e->vals[sq] == EMPTY);
+    assert(ss->st.vals[sq] == EMPTY);
+    assert(xchk[sq] == ANYTILE); // see section 3.3.1 Placing Left Parts
+    assert(sq >= start);
 
-    for (const char* tile = edges; *tile != 0; ++tile) {
-        const char tint = tilenum(*tile);
-        if (rack[tint] == 0) {              // have tile?
-            continue;
+    const u32 edges = lexedges(lex, node) & LETTERS;
+    if (ss->blanks >= 0) {
+        const u32 wild = (rack->mask & (1u << BLANK)) != 0 ? edges : edges & rack->mask;
+        for (u32 msk = wild; msk != 0; msk = clearlsb(msk)) {
+            const int tint = lsb(msk);
+            const rack_tile tile = (rack->mask & (1u << tint)) != 0 ? tint : BLANK;
+            rack_take(rack, tile);
+            word->buf[word->len++] = 'A' + tint;
+            left_part(ss, sq - 1, limit - 1, lexchild(lex, node, tint), word);
+            word->len--;
+            rack_put(rack, tile);
         }
-        assert(xchk[sq] == ANYTILE); // see section 3.3.1 Placing Left Parts
-        rack[tint]--;
-        word->buf[word->len++] = *tile; // TODO: hoist incr of len
-        word->buf[word->len]   = 0;     // TODO: hoist this out of loop
-        assert(sq >= start);
-        left_part(ss, sq - stride, limit - 1, word); // try to expand the left part more to the left
-        word->len--;                    // TODO: hoist out of loop
-        word->buf[word->len] = 0;       // TODO: hoist this out of loop
-        rack[tint]++;
+        return;
     }
-    if (rack[BLANK] > 0) {
-        for (const char* tile = edges; *tile != 0; ++tile) {
-            assert(xchk[sq] == ANYTILE); // see section 3.3.1 Placing Left Parts
-            rack[BLANK]--;                        // TODO: hoist out of loop
-            word->buf[word->len++] = 'a' + (*tile - 'A'); // TODO: hoist len incr out of loop
-            word->buf[word->len]   = 0;           // TODO: hoist this out of loop
-            assert(sq >= start);
-            left_part(ss, sq - stride, limit - 1, word); // try to expand the left part more to the left
-            word->len--;                    // TODO: hoist out of loop
-            word->buf[word->len] = 0;       // TODO: hoist this out of loop
-            rack[BLANK]++;                  // TODO: hoist out of loop
+    for (u32 msk = edges & rack->mask; msk != 0; msk = clearlsb(msk)) { // have tile?
+        const int tint = lsb(msk);
+        rack_take(rack, tint);
+        word->buf[word->len++] = 'A' + tint;
+        left_part(ss, sq - 1, limit - 1, lexchild(lex, node, tint), word); // try to expand the left part more to the left
+        word->len--;
+        rack_put(rack, tint);
+    }
+    if ((rack->mask & (1u << BLANK)) != 0) {
+        rack_take(rack, BLANK);
+        for (u32 msk = edges; msk != 0; msk = clearlsb(msk)) {
+            const int tint = lsb(msk);
+            word->buf[word->len++] = 'a' + tint;
+            left_part(ss, sq - 1, limit - 1, lexchild(lex, node, tint), word); // try to expand the left part more to the left
+            word->len--;
         }
+        rack_put(rack, BLANK);
     }
 }
 
-internal void extend_right_on_existing_left_part(const state* ss, int anchor, string* word)
+// Walks the tiles before the anchor into `word`, `node` and `sc`. Returns the
+// square of the first of them, or -1 if they aren't a prefix of any word.
+internal int existing_left_part(const state* ss, string* word, cicero_node* node, runscore* sc)
 {
     const cicero *e = ss->e;
-    const char *vals = e->vals;
+    const cicero_lexicon* lex = &e->cb.lexicon;
+    const char *vals = ss->st.vals;
+    const int anchor = ss->anchor;
     const int start  = ss->start;
-    const int stride = ss->stride;
     const int stop   = ss->stop;
-    int sq = anchor - stride;
-    assert(start <= sq && sq < stop);
-    assert(vals[sq] != EMPTY);
-    // TODO: more efficient way to extend backwards? maybe make the buffer (DIM+1)*2 so we can start
-    //       in the middle?
-    while (start <= sq && vals[sq] != EMPTY) {
+    const int lsq    = findbeg(vals, start, stop, 1, anchor);
+    assert(start <= lsq && lsq < anchor);
+    assert(vals[lsq] != EMPTY);
+    *node = lex->root(lex->data);
+    *sc   = NOSCORE;
+    for (int sq = lsq; sq != anchor; ++sq) {
+        const int tint = vals[sq] < BLANK ? vals[sq] : vals[sq] - BLANK; // ignore blankness
+        if ((lexedges(lex, *node) & tilemask(tint)) == 0) {
+            word->len = 0;
+            return -1; // left part isn't a prefix of any word
+        }
+        *node = lexchild(lex, *node, tint);
+        *sc   = score_existing(&ss->st, *sc, sq);
         word->buf[word->len++] = to_ext(vals[sq]);
-        sq -= stride;
     }
-    word->buf[word->len] = 0;
-    revbuf(word->buf, word->len);
-    extend_right(ss, anchor - stride * word->len, anchor, word, /*right_part_length*/0);
+    return lsq;
+}
+
+// the moves that extend the tiles before the anchor
+internal void extend_right_on_existing_left_part(const state* ss, string* word)
+{
+    cicero_node node;
+    runscore sc;
+    const int lsq = existing_left_part(ss, word, &node, &sc);
+    if (lsq < 0) {
+        return;
+    }
+    extend_right(ss, lsq, ss->anchor, node, word, sc);
     word->len = 0;
 }
 
-void cicero_generate_legal_moves(const cicero *e, cicero_rack rack)
+internal void init_state(state* ss, const cicero* e, cicero_packed_rack* rack, cicero_move_sink* sink, topk* top)
+{
+    ss->e       = e;
+    ss->r       = rack;
+    ss->sink    = sink;
+    ss->top     = top;
+    ss->suspend = 0;
+    ss->blanks  = -1;
+    init_scoretab(&ss->st, e);
+}
+
+// set up `ss` for the moves through the square `anchor` in direction `dir`
+internal void set_lane(state* ss, int anchor, int dir)
+{
+    const cicero* e = ss->e;
+    const int sq    = lane_square(dir, anchor);
+    const int start = colstart(sq);
+    set_scoretab_dir(&ss->st, e, dir);
+    ss->anchor      = sq;
+    ss->start       = start;
+    ss->stop        = start + DIM;
+    ss->dir         = dir;
+    ss->xchk        = dir == HORZ ? e->hchk : e->tvchk;
+    ss->left_placed = !(sq - 1 >= start && ss->st.vals[sq - 1] != EMPTY);
+}
+
+// max left part potential length
+internal int left_limit(const state* ss)
+{
+    const u64  *asqs   = ss->e->asqs;
+    const char *vals   = ss->st.vals;
+    const int   anchor = ss->anchor;
+    const int   start  = ss->start;
+    const int   dir    = ss->dir;
+    int limit = 0;
+    for (int sq = anchor - 1; sq >= start; --sq) {
+        if (getasq(asqs, lane_square(dir, sq)) != 0) {
+            break;
+        }
+        if (vals[sq] != EMPTY) {
+            break;
+        }
+        ++limit;
+    }
+    const int left_most_poss_sq = anchor - limit;
+    assert(left_most_poss_sq >= start);
+    assert((left_most_poss_sq == start) ||
+           (
+                (getasq(asqs, lane_square(dir, left_most_poss_sq)) != 0) ||
+                (vals[left_most_poss_sq] == EMPTY)
+           ));
+    return limit;
+}
+
+internal void gen_lane(const state* ss, cicero_node root, string* word)
+{
+    if (!ss->left_placed) {
+        extend_right_on_existing_left_part(ss, word);
+    } else {
+        left_part(ss, ss->anchor - 1, left_limit(ss), root, word);
+    }
+}
+
+// The same search as left_part and extend_right, a square at a time, but
+// with a frame per square on an explicit stack instead of recursing, so that
+// it can stop once the sink is full and go on from there later, see
+// cicero_movegen. It only has the plain moves cicero_movegen needs, no
+// wildcards or best moves: the recursive search is still the faster of the
+// two, so the other generators use it.
+
+// What a frame does when it is next on top of the stack
+enum
+{
+    STEP_EXTEND, // left part: extend the left part so far right, through the anchor
+    STEP_GROW,   // ... then grow it by a letter on the frame's square
+    STEP_ENTER,  // right part: go on past the tiles on the board, emit the move
+                 // so far, then a letter on the next empty square
+    STEP_PLACE,  // ... the letter part, if the search stopped after the move
+    STEP_REAL,   // placing the rack's letters on the square, one per child frame
+    STEP_BLANK,  // ... then the blank as each letter
+};
+
+static const u8 NOTILE = 0xff;
+
+// A square of the move being generated. Left part frames are on the squares
+// before the anchor, right part frames on the anchor and after it.
+struct frame
+{
+    cicero_node node;    // lexicon node of the tiles before the square
+    u32         letters; // letters left to try on the square
+    u32         blanks;  // ... as the rack's blank, once those are done
+    runscore    sc;      // right part: score of the move so far
+    short       sq;      // lane square
+    u8          step;
+    u8          tile;    // rack tile taken for the child frame, NOTILE if none
+};
+typedef struct frame frame;
+
+// deepest the stack gets: DIM + 2, a frame per lane square, one past the
+// last and one before the first
+enum { MAXFRAMES = 17 };
+_Static_assert(sizeof(frame) * MAXFRAMES <= sizeof(((cicero_movegen*)0)->stack));
+
+// sets up `f` to place each of `letters` that the rack has on its square
+internal void place_letters(const state* ss, frame* f, u32 letters)
+{
+    const u32 mask = ss->r->mask;
+    f->tile    = NOTILE;
+    f->step    = STEP_REAL;
+    f->letters = letters & mask;
+    f->blanks  = (mask & (1u << BLANK)) != 0 ? letters : 0;
+}
+
+// Runs the search from the frame `f` on top of `stack` until stack[0] is
+// popped, and returns NULL. With ss->suspend it returns the frame on top
+// instead once the sink is full, to be passed back in to go on. `lsq` is the
+// left-most square of the move if it starts with a right part, and `limit` is
+// the longest left part from the rack. `word` holds the move up to the
+// square of the frame on top, each frame sets word->len for its square so a
+// frame can just be popped.
+internal frame* search(const state* ss, frame* stack, frame* f, int* lsqp, int limit, string* word)
+{
+    const cicero* e = ss->e;
+    const cicero_lexicon* lex = &e->cb.lexicon;
+    cicero_packed_rack* rack = ss->r;
+    const char* vals = ss->st.vals;
+    const u32*  xchk = ss->xchk;
+    const int anchor = ss->anchor;
+    const int stop   = ss->stop;
+    int       lsq    = *lsqp;
+
+    assert(ss->blanks < 0 && !ss->top);
+    while (f >= stack) {
+        assert(f < stack + MAXFRAMES);
+        switch (f->step) {
+        case STEP_EXTEND: {
+            assert(anchor - f->sq - 1 == word->len);
+            lsq = f->sq + 1;
+            f->step = STEP_GROW;
+            frame* child = f + 1;
+            child->node = f->node;
+            child->sc   = NOSCORE;
+            child->sq   = (short)anchor;
+            child->step = STEP_ENTER;
+            f = child;
+            break;
+        }
+        case STEP_GROW:
+            word->len = anchor - f->sq - 1;
+            if (word->len == limit) {
+                --f;
+                break;
+            }
+            assert(vals[f->sq] == EMPTY);
+            assert(xchk[f->sq] == ANYTILE); // see section 3.3.1 Placing Left Parts
+            assert(f->sq >= ss->start);
+            place_letters(ss, f, lexedges(lex, f->node) & LETTERS);
+            break;
+        case STEP_ENTER: {
+            int sq = f->sq;
+            cicero_node node = f->node;
+            for (; sq < stop && vals[sq] != EMPTY && node != NONODE; ++sq) {
+                const int tint = vals[sq] < BLANK ? vals[sq] : vals[sq] - BLANK; // ignore blankness
+                node = (lexedges(lex, node) & tilemask(tint)) != 0 ? lexchild(lex, node, tint) : NONODE;
+                f->sc = score_existing(&ss->st, f->sc, sq);
+                word->buf[word->len++] = to_ext(vals[sq]);
+            }
+            if (node == NONODE) {
+                --f;
+                break;
+            }
+            f->node = node;
+            f->sq   = (short)sq;
+            const u32 edges = lexedges(lex, node);
+            // a left part from the rack isn't counted in `sc` until it is scored
+            const int ntiles = f->sc.ntiles + (ss->left_placed ? anchor - lsq : 0);
+            const int second = second_direction(ss->st.xscr, anchor, ss->dir, ntiles);
+            if (sq > anchor && second >= 0 && (edges & CICERO_TERMINAL) != 0) {
+                const runscore total = ss->left_placed ? score_left_part(ss, lsq, word, f->sc) : f->sc;
+                emit_move(ss, lsq, word, second, score_total(e, total));
+            }
+            if (ss->suspend && ss->sink->total - ss->sink->skip >= ss->sink->cap) {
+                f->step = STEP_PLACE;
+                *lsqp = lsq;
+                return f;
+            }
+            if (sq >= stop) { // hit end of board
+                --f;
+                break;
+            }
+            place_letters(ss, f, edges & xchk[sq] & LETTERS); // meets cross-check?
+            break;
+        }
+        case STEP_PLACE:
+            if (f->sq >= stop) {
+                --f;
+                break;
+            }
+            place_letters(ss, f, lexedges(lex, f->node) & xchk[f->sq] & LETTERS);
+            break;
+        default: { // the next letter on the square
+            assert(f->step == STEP_REAL || f->step == STEP_BLANK);
+            if (f->tile != NOTILE) {
+                rack_put(rack, f->tile);
+                f->tile = NOTILE;
+            }
+            if (f->letters == 0) {
+                // NOTE: the blank is tried as every letter after the real
+                //       tiles, to check both paths if I have the letter too
+                if (f->step == STEP_REAL && f->blanks != 0) {
+                    f->step    = STEP_BLANK;
+                    f->letters = f->blanks;
+                } else {
+                    --f;
+                }
+                break;
+            }
+            const int tint = lsb(f->letters);
+            f->letters = clearlsb(f->letters);
+            rack_tile tile = tint;
+            eng_tile placed = (eng_tile)tint;
+            char c = 'A' + tint;
+            if (f->step == STEP_BLANK) {
+                tile   = BLANK;
+                placed = BLANK + tint;
+                c      = 'a' + tint;
+            }
+            rack_take(rack, tile);
+            f->tile = (u8)tile;
+            word->len = f->sq < anchor ? anchor - f->sq - 1 : f->sq - lsq;
+            word->buf[word->len++] = c;
+            assert(word->len <= DIM);
+            frame* child = f + 1;
+            child->node = lexchild(lex, f->node, tint);
+            if (f->sq < anchor) {
+                child->sq   = (short)(f->sq - 1);
+                child->step = STEP_EXTEND;
+            } else {
+                child->sc   = score_placed(&ss->st, f->sc, f->sq, placed);
+                child->sq   = (short)(f->sq + 1);
+                child->step = STEP_ENTER;
+            }
+            f = child;
+            break;
+        }
+        }
+    }
+    return NULL;
+}
+
+// Sets up stack[0], `lsq` and `limit` for the search of the lane, with the
+// tiles before the anchor in `word`. Returns 0 if the lane has no moves.
+internal int start_search(const state* ss, frame* stack, cicero_node root, string* word, int* lsq, int* limit)
+{
+    if (ss->left_placed) {
+        stack[0].node = root;
+        stack[0].sq   = (short)(ss->anchor - 1);
+        stack[0].step = STEP_EXTEND;
+        *lsq   = ss->anchor;
+        *limit = left_limit(ss);
+        return 1;
+    }
+    cicero_node node;
+    runscore sc;
+    *lsq = existing_left_part(ss, word, &node, &sc);
+    if (*lsq < 0) {
+        return 0;
+    }
+    stack[0].node = node;
+    stack[0].sc   = sc;
+    stack[0].sq   = (short)ss->anchor;
+    stack[0].step = STEP_ENTER;
+    *limit = 0;
+    return 1;
+}
+
+// `blanks` is a cicero_blanks mode, or -1, see state::blanks
+internal void generate(const cicero *e, cicero_rack rack, cicero_move_sink *sink, int blanks)
 {
     const int dirs[] = { HORZ, VERT };
     const u64  *asqs = e->asqs;
-    const char *vals = e->vals;
+    const cicero_lexicon *lex = &e->cb.lexicon;
+    const cicero_node root = lex->root(lex->data);
     string word;
     word.len = 0;
     word.buf[0] = 0;
+    cicero_packed_rack packed = cicero_pack_rack(&rack);
     state ss;
-    ss.e = e;
-    ss.r = &rack;
+    init_state(&ss, e, &packed, sink, NULL);
+    ss.blanks = blanks;
+    ss.rack0  = packed;
     for (int i = 0; i < 4; ++i) {
         const int base = 64*i;
         u64 msk = asqs[i];
         while (msk > 0) {
             const int anchor = base + lsb(msk);
             for (int i = 0; i < ASIZE(dirs); ++i) {
-                const int stride  = dirs[i];
-                const int start = dirs[i] == HORZ ? colstart(anchor) : rowstart(anchor);
-                ss.anchor = anchor;
-                ss.start  = start;
-                ss.stride = stride;
-                ss.stop   = start + DIM * stride;
-                ss.xchk   = dirs[i] == HORZ ? e->hchk : e->vchk;
-                if (anchor - stride >= start && vals[anchor - stride] != EMPTY) {
-                    extend_right_on_existing_left_part(&ss, anchor, &word);
-                } else {
-                    int limit = 0; // max left part potential length
-                    for (int sq = anchor - stride; sq >= start; sq -= stride) {
-                        if (getasq(asqs, sq) != 0) {
-                            break;
-                        }
-                        if (vals[sq] != EMPTY) {
-                            break;
-                        }
-                        ++limit;
-                    }
-                    const int left_most_poss_sq = anchor - stride * limit;
-                    assert(left_most_poss_sq >= start);
-                    assert((left_most_poss_sq == start) ||
-                           (
-                                (getasq(asqs, left_most_poss_sq) != 0) ||
-                                (vals[left_most_poss_sq] == EMPTY)
-                           ));
-                    left_part(&ss, anchor - stride, limit, &word);
-                }
+                set_lane(&ss, anchor, dirs[i]);
+                gen_lane(&ss, root, &word);
             }
 
             msk = clearlsb(msk);
         }
     }
 }
+
+internal int by_rank(const void* a, const void* b)
+{
+    return cicero_compare_move_records((const cicero_move_record*)a, (const cicero_move_record*)b);
+}
+
+int cicero_find_top_k(const cicero *e, cicero_rack rack, cicero_move_record *moves, int k)
+{
+    if (k <= 0) {
+        return 0;
+    }
+    const int dirs[] = { HORZ, VERT };
+    const cicero_lexicon *lex = &e->cb.lexicon;
+    const cicero_node root = lex->root(lex->data);
+    string word;
+    word.len = 0;
+    word.buf[0] = 0;
+    topk top;
+    top.heap = moves;
+    top.cap  = k;
+    top.len  = 0;
+    cicero_packed_rack packed = cicero_pack_rack(&rack);
+    state ss;
+    init_state(&ss, e, &packed, NULL, &top);
+    for (int i = 0; i < 4; ++i) {
+        for (u64 msk = e->asqs[i]; msk > 0; msk = clearlsb(msk)) {
+            const int anchor = 64*i + lsb(msk);
+            for (int d = 0; d < ASIZE(dirs); ++d) {
+                set_lane(&ss, anchor, dirs[d]);
+                gen_lane(&ss, root, &word);
+            }
+        }
+    }
+    qsort(moves, (size_t)top.len, sizeof(moves[0]), &by_rank);
+    return top.len;
+}
+
+void cicero_generate_legal_moves(const cicero *e, cicero_rack rack)
+{
+    generate(e, rack, NULL, -1);
+}
+
+void cicero_generate_legal_moves_into(const cicero *e, cicero_rack rack, cicero_move_sink *sink)
+{
+    sink->total = 0;
+    generate(e, rack, sink, -1);
+    sink->len = sink_len(sink);
+}
+
+void cicero_generate_legal_moves_blanks_into(const cicero *e, cicero_rack rack, cicero_blanks blanks, cicero_move_sink *sink)
+{
+    sink->total = 0;
+    generate(e, rack, sink, blanks);
+    sink->len = sink_len(sink);
+}
+
+// an item is the anchor square times 2, plus 1 for VERT
+int cicero_move_items(const cicero *e, int *items)
+{
+    int n = 0;
+    for (int i = 0; i < 4; ++i) {
+        for (u64 msk = e->asqs[i]; msk > 0; msk = clearlsb(msk)) {
+            const int anchor = 64*i + lsb(msk);
+            items[n++] = 2 * anchor;
+            items[n++] = 2 * anchor + 1;
+        }
+    }
+    return n;
+}
+
+void cicero_generate_items_into(const cicero *e, cicero_rack rack, const int *items, int n, cicero_move_sink *sink)
+{
+    const cicero_lexicon *lex = &e->cb.lexicon;
+    const cicero_node root = lex->root(lex->data);
+    string word;
+    word.len = 0;
+    word.buf[0] = 0;
+    cicero_packed_rack packed = cicero_pack_rack(&rack);
+    state ss;
+    init_state(&ss, e, &packed, sink, NULL);
+    sink->total = 0;
+    for (int i = 0; i < n; ++i) {
+        assert(0 <= items[i] && items[i] < 2 * NUM_SQUARES);
+        set_lane(&ss, items[i] / 2, items[i] % 2 == 0 ? HORZ : VERT);
+        gen_lane(&ss, root, &word);
+    }
+    sink->len = sink_len(sink);
+}
+
+void cicero_movegen_start(cicero_movegen *gen, const cicero *e, cicero_rack rack)
+{
+    gen->e      = e;
+    gen->rack   = cicero_pack_rack(&rack);
+    gen->nitems = cicero_move_items(e, gen->items);
+    gen->item   = 0;
+    gen->top    = -1;
+    gen->len    = 0;
+}
+
+int cicero_movegen_resume(cicero_movegen *gen, cicero_move_sink *sink)
+{
+    assert(sink->cap > 0);
+    const cicero_lexicon *lex = &gen->e->cb.lexicon;
+    const cicero_node root = lex->root(lex->data);
+    frame* stack = (frame*)gen->stack;
+    const long skip = sink->skip;
+    string word;
+    memcpy(word.buf, gen->word, sizeof(word.buf));
+    word.len = gen->len;
+    state ss;
+    init_state(&ss, gen->e, &gen->rack, sink, NULL);
+    ss.suspend  = 1;
+    sink->skip  = 0;
+    sink->total = 0;
+    int more = 0;
+    for (; gen->item < gen->nitems; ++gen->item, gen->top = -1) {
+        const int item = gen->items[gen->item];
+        set_lane(&ss, item / 2, item % 2 == 0 ? HORZ : VERT);
+        if (gen->top < 0 && !start_search(&ss, stack, root, &word, &gen->lsq, &gen->limit)) {
+            continue;
+        }
+        frame* f = search(&ss, stack, gen->top < 0 ? stack : stack + gen->top, &gen->lsq, gen->limit, &word);
+        if (f) {
+            gen->top = (int)(f - stack);
+            more = 1;
+            break;
+        }
+        word.len = 0;
+    }
+    memcpy(gen->word, word.buf, sizeof(gen->word));
+    gen->len   = word.len;
+    sink->len  = sink_len(sink);
+    sink->skip = skip;
+    return more;
+}
@@ -27,3 +27,25 @@ void cicero_rack_add_tile(cicero_rack* rack, char tile)
     assert(('A' <= tile && tile <= 'Z') || tile == CICERO_TILE_BLANK);
     rack->tiles[char_to_rack_tile(tile)]++;
 }
+
+cicero_packed_rack cicero_pack_rack(const cicero_rack *rack)
+{
+    cicero_packed_rack result;
+    memset(&result, 0, sizeof(result));
+    for (rack_tile tile = 0; tile < ASIZE(rack->tiles); ++tile) {
+        assert(0 <= rack->tiles[tile]);
+        const int count = rack->tiles[tile] < 15 ? rack->tiles[tile] : 15; // all a nibble holds
+        result.counts[tile >> 4] |= (u64)count << (4 * (tile & 15));
+        if (rack->tiles[tile] > 0) {
+            result.mask |= 1u << tile;
+        }
+    }
+    return result;
+}
+
+void cicero_unpack_rack(cicero_rack *rack, const cicero_packed_rack *packed)
+{
+    for (rack_tile tile = 0; tile < ASIZE(rack->tiles); ++tile) {
+        rack->tiles[tile] = rack_count(packed, tile);
+    }
+}
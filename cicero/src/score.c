@@ -34,22 +34,21 @@ int cicero_score_move(const cicero *e, const cicero_move *move)
 // ".NT"
 //
 // Will I correctly include the value of the 'S'?
-int cicero_score_move2(const cicero *e, const cicero_move2 *move)
+kernel int score_move_dir(const cicero *e, const cicero_move2 *move, int dir)
 {
     const char *board   = e->vals;
     const char *tiles   = move->tiles;
-    const u16  *xscr    = move->direction == CICERO_HORZ ? e->hscr : e->vscr;
+    const u16  *xscr    = dir == CICERO_HORZ ? e->hscr : e->vscr;
     const int   root    = move->square;
-    const int   stride = move->direction;
+    const int   stride  = dir;
     const int  *dlsqs   = e->s.double_letter_squares;
     const int  *tlsqs   = e->s.triple_letter_squares;
     const int  *dwsqs   = e->s.double_word_squares;
     const int  *twsqs   = e->s.triple_word_squares;
     const int  *letter_values = e->s.letter_values;
-    const dimstart hstart = move->direction == CICERO_HORZ ? colstart : rowstart;
 
     int word_score = 0;
-    const int start  = hstart(root);
+    const int start  = lanestart(stride, root);
     const int stop   = start + DIM * stride;
     const int first  = findbeg(board, start, stop, stride, root);
     for (int sq = first; sq < stop && board[sq] != EMPTY; sq += stride) {
@@ -89,6 +88,12 @@ int cicero_score_move2(const cicero *e, const cicero_move2 *move)
     return root_score + cross_score + bingo_bonus;
 }
 
+int cicero_score_move2(const cicero *e, const cicero_move2 *move)
+{
+    assert(move->direction == CICERO_HORZ || move->direction == CICERO_VERT);
+    return move->direction == CICERO_HORZ ? score_move_dir(e, move, CICERO_HORZ) : score_move_dir(e, move, CICERO_VERT);
+}
+
 cicero_multiplier cicero_square_multiplier(const cicero* e, int sq)
 {
     if (!(0 <= sq && sq < 225)) {
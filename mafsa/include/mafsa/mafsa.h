@@ -6,14 +6,36 @@ extern "C" {
 
 // TODO: add allocate / deallocate API for custom allocators
 
-struct mafsa_node_ { int children[26]; };
-typedef struct mafsa_node_ mafsa_node_;
+// edges 0-25 are the letters A-Z. MAFSA_SEP is only used by GADDAGs, it is
+// the "turn around" marker between the reversed prefix and the suffix
+// (written as '^' in input strings).
+#define MAFSA_SEP    26
+#define MAFSA_NEDGES 27
+
+// packed states: a state is an offset into `mafsa::data`. data[s] holds the
+// state's outgoing edges in bits 0-26, and MAFSA_TERM if it is terminal. The
+// children follow it in edge order, so the child for edge `c` is
+// data[s + 1 + popcount(data[s] & ((1 << c) - 1))].
+#define MAFSA_TERM   (1u << 31)
+#define MAFSA_EDGES  ((1u << MAFSA_NEDGES) - 1u)
+
+// One automaton can hold up to MAFSA_MAX_LEXICONS lexicons (e.g. CSW19 and
+// TWL06), sharing the states of words they have in common. Bit
+// MAFSA_LEXSHIFT + l of data[s] is set if `s` is terminal in lexicon `l`
+// (MAFSA_TERM if it is terminal in any). Child entries hold the child's
+// offset in MAFSA_OFFSET, and in the bits above it the lexicons that have a
+// word below that child, so edges can be filtered per lexicon without
+// visiting the children. Plain inserts go into lexicon 0.
+#define MAFSA_MAX_LEXICONS 4
+#define MAFSA_LEXSHIFT     MAFSA_NEDGES
+#define MAFSA_LEXICONS     (((1u << MAFSA_MAX_LEXICONS) - 1u) << MAFSA_LEXSHIFT)
+#define MAFSA_OFFSET       ((1u << MAFSA_LEXSHIFT) - 1u)
 
 struct mafsa
 {
-    mafsa_node_  *nodes;
-    unsigned int *terms;
-    int           size;
+    unsigned int *data;
+    int           size;    // # of entries in `data`
+    int           nstates;
 };
 typedef struct mafsa mafsa;
 
@@ -27,20 +49,60 @@ typedef struct mafsa_edges mafsa_edges;
 extern int  mafsa_isword(const mafsa *m, const char *const word);
 extern int  mafsa_isterm(const mafsa *m, int s);
 extern void mafsa_free(mafsa *m);
+// the letters (bits 0-25) that can follow `word`, and MAFSA_TERM if `word` is
+// a word; 0 if no word starts with `word`
+extern unsigned int mafsa_prefix_mask(const mafsa *m, const char *const word);
+// string form of mafsa_prefix_mask, kept for existing callers
 extern mafsa_edges mafsa_prefix_edges(const mafsa *m, const char *const word);
 
+// state cursor API: the root is state 0, and child states are only valid
+// for letters (0-25) set in the state's edge mask
+extern int          mafsa_root(const mafsa *m);
+extern int          mafsa_child(const mafsa *m, int s, int c);
+extern unsigned int mafsa_edgemask(const mafsa *m, int s);
+
+// the same queries restricted to one lexicon, 0 <= `lexicon` < MAFSA_MAX_LEXICONS
+extern int          mafsa_isword_in(const mafsa *m, const char *const word, int lexicon);
+extern int          mafsa_isterm_in(const mafsa *m, int s, int lexicon);
+extern unsigned int mafsa_prefix_mask_in(const mafsa *m, const char *const word, int lexicon);
+extern mafsa_edges  mafsa_prefix_edges_in(const mafsa *m, const char *const word, int lexicon);
+// the edges of `s` that lead to at least one word in `lexicon`
+extern unsigned int mafsa_edgemask_in(const mafsa *m, int s, int lexicon);
+
+
+// unpacked state used while building, one slot per edge (0 = no edge)
+struct mafsa_builder_node_ { int children[MAFSA_NEDGES]; };
+typedef struct mafsa_builder_node_ mafsa_builder_node_;
 
 struct mafsa_builder
 {
-    mafsa_node_ *nodes;
-    int         *terms;
-    int          size;
-    int          capacity;
+    mafsa_builder_node_ *nodes;
+    int                 *terms; // lexicons the state is terminal in
+    int                  size;
+    int                  capacity;
 };
 typedef struct mafsa_builder mafsa_builder;
 
 extern int mafsa_builder_start (mafsa_builder *m);
 extern int mafsa_builder_insert(mafsa_builder *m, const char *const word);
+// inserts the GADDAG paths for `word`: REV(word[0:i]) ^ word[i:] for
+// 0 < i < len, and REV(word). `word` must be at most 15 letters.
+extern int mafsa_builder_insert_gaddag(mafsa_builder *m, const char *const word);
+// only inserts the GADDAG paths whose first letter is set in `firsts` (bit 0 is
+// 'A'), used to split a GADDAG build into shards
+extern int mafsa_builder_insert_gaddag_some(mafsa_builder *m, const char *const word, unsigned int firsts);
+// insert `word` into each lexicon set in `lexicons` (bit `l` is lexicon `l`)
+extern int mafsa_builder_insert_in(mafsa_builder *m, const char *const word, unsigned int lexicons);
+extern int mafsa_builder_insert_gaddag_in(mafsa_builder *m, const char *const word, unsigned int lexicons,
+        unsigned int firsts);
+// minimizes the builder in place, no more words may be inserted afterwards
+extern int mafsa_builder_minimize(mafsa_builder *m);
+// moves the states of `shards` into `m`, joining their roots with m's root.
+// The roots must not share any edges, e.g. each one holds the words starting
+// with different letters. `shards` are left empty. Returns -1 if the roots
+// overlap.
+extern int mafsa_builder_merge(mafsa_builder *m, mafsa_builder *shards, int nshards);
+// returns -1 if the packed automaton would be too large for MAFSA_OFFSET
 extern int mafsa_builder_finish(mafsa_builder *m, mafsa *out);
 
 #ifdef __cplusplus
@@ -3,14 +3,12 @@
 #include <assert.h>
 #include <string.h>
 #include "iconv.h"
-#include "khash.h"
-#include "kvec.h"
 
 #include <stdio.h> // TEMP TEMP
 
 
 typedef unsigned int uint;
-typedef mafsa_node_  node;
+typedef mafsa_builder_node_ node;
 
 
 static int expand(mafsa_builder *m, size_t amount)
@@ -43,18 +41,26 @@ int mafsa_builder_start(mafsa_builder *m)
 #define TRY(x) if ((rc = (x)) != 0) { return rc; }
 
 int mafsa_builder_insert(mafsa_builder *m, const char* const word)
+{
+    return mafsa_builder_insert_in(m, word, 1u);
+}
+
+int mafsa_builder_insert_in(mafsa_builder *m, const char* const word, unsigned int lexicons)
 {
     int rc;
     int s = 0;
+    if (lexicons == 0 || (lexicons & ~(MAFSA_LEXICONS >> MAFSA_LEXSHIFT)) != 0) {
+        return -1;
+    }
     for (const char *p = word; *p != '\0'; ++p) {
         const int c = iconv(*p);
         assert(0 <= s && s < m->size);
-        assert(0 <= c && c < 26);
+        assert(0 <= c && c < MAFSA_NEDGES);
         const int t = m->nodes[s].children[c];
         if (t == 0) {
             const int next = m->size++;
             if (m->size >= m->capacity) {
-                TRY(expand(m, 10));
+                TRY(expand(m, (size_t)m->capacity));
             }
             m->nodes[s].children[c] = next;
             m->terms[next] = 0;
@@ -64,21 +70,75 @@ int mafsa_builder_insert(mafsa_builder *m, const char* const word)
         }
     }
     assert(0 <= s && s < m->size);
-    m->terms[s] = 1;
+    m->terms[s] |= (int)lexicons;
     return 0;
 }
 
-KHASH_MAP_INIT_INT(m32, int);
+int mafsa_builder_insert_gaddag(mafsa_builder *m, const char* const word)
+{
+    return mafsa_builder_insert_gaddag_in(m, word, 1u, ~0u);
+}
+
+int mafsa_builder_insert_gaddag_some(mafsa_builder *m, const char* const word, unsigned int firsts)
+{
+    return mafsa_builder_insert_gaddag_in(m, word, 1u, firsts);
+}
+
+int mafsa_builder_insert_gaddag_in(mafsa_builder *m, const char* const word, unsigned int lexicons,
+        unsigned int firsts)
+{
+    int rc;
+    char buf[2*16 + 1];
+    const int len = (int)strlen(word);
+    if (len > 15) {
+        return -1;
+    }
+    for (int i = 1; i <= len; ++i) {
+        if ((firsts & (1u << iconv(word[i - 1]))) == 0) {
+            continue;
+        }
+        char *p = &buf[0];
+        for (int j = i - 1; j >= 0; --j) {
+            *p++ = word[j];
+        }
+        if (i != len) {
+            *p++ = '^';
+            for (int j = i; j < len; ++j) {
+                *p++ = word[j];
+            }
+        }
+        *p = '\0';
+        TRY(mafsa_builder_insert_in(m, buf, lexicons));
+    }
+    return 0;
+}
 
-typedef kvec_t(int) vec_t;
-typedef khash_t(m32) ht_t;
+// The register holds one representative state per equivalence class. It is an
+// open-addressing hash table of state indices (0 = empty slot, the root is
+// never registered) keyed on the state's right language signature: its final
+// flag and its (already minimized) transitions.
 struct reduce_state
 {
-    vec_t reg;
-    ht_t *rep;
+    int *reg;  // register slots
+    uint mask; // # of slots - 1, always a power of 2 minus 1
+    int *rep;  // rep[s] is the representative of `s` once visited: `s` itself
+               // if registered, otherwise an equivalent registered state.
+               // 0 if not visited (yet), i.e. unreachable.
 };
 typedef struct reduce_state reduce_state;
 
+static uint nodehash(const mafsa_builder *m, int s)
+{
+    // FNV-1a over the state's signature
+    uint h = 2166136261u ^ (uint)m->terms[s];
+    h *= 16777619u;
+    for (int i = 0; i < MAFSA_NEDGES; ++i) {
+        h ^= (uint)m->nodes[s].children[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
 int nodecmp(const mafsa_builder *m, int s, int t)
 {
     // from https://www.aclweb.org/anthology/J00-1002.pdf pg. 7:
@@ -92,7 +152,6 @@ int nodecmp(const mafsa_builder *m, int s, int t)
 	// 3. corresponding outgoing transitions have the same labels; and
     // 4'. corresponding transitions lead to the same states.
 
-    // TODO: do I need to verify that the value is the same?
     if (m->terms[s] != m->terms[t]) {
         return 1;
     }
@@ -101,104 +160,96 @@ int nodecmp(const mafsa_builder *m, int s, int t)
 
 void visit_post(mafsa_builder *m, int s, reduce_state *state)
 {
-    int ret;
-    khiter_t k;
-    vec_t *reg = &state->reg;
-    ht_t  *rep = state->rep;
-
     assert(s < m->size);
-    for (int i = 0; i < 26; ++i) {
-        const int t = m->nodes[s].children[i];
+    // states can be shared if the builder was already (partially) minimized
+    if (state->rep[s] != 0) {
+        return;
+    }
+    int *children = m->nodes[s].children;
+    for (int i = 0; i < MAFSA_NEDGES; ++i) {
+        const int t = children[i];
         if (t != 0) {
             visit_post(m, t, state);
+            assert(state->rep[t] != 0);
+            children[i] = state->rep[t];
         }
     }
 
-    {
-        for (int i = 0; i < 26; ++i) {
-            const int t = m->nodes[s].children[i];
-            if (t == 0) {
-                continue;
-            }
-            k = kh_get(m32, rep, t);
-            if (k == kh_end(rep)) {
-                continue;
-            }
-            m->nodes[s].children[i] = kh_value(rep, k);
-        }
+    if (s == 0) {
+        return;
+    }
 
-        if (s == 0) {
+    // all children are registered by now, so `s` is equivalent to a
+    // registered state iff their signatures are identical
+    uint slot = nodehash(m, s) & state->mask;
+    for (;;) {
+        const int t = state->reg[slot];
+        if (t == 0) {
+            state->reg[slot] = s;
+            state->rep[s] = s;
             return;
         }
-
-        for (int i = 0; i < kv_size(*reg); ++i) {
-            const int t = kv_A(*reg, i);
-            assert(kh_get(m32, rep, t) == kh_end(rep));
-            if (nodecmp(m, s, t) == 0) {
-                k = kh_put(m32, rep, s, &ret);
-                assert(k != kh_end(rep));
-                assert(ret != -1 && ret != 0);
-                kh_value(rep, k) = t;
-                return;
-            }
+        if (nodecmp(m, s, t) == 0) {
+            state->rep[s] = t;
+            return;
         }
-
-        kv_push(int, *reg, s);
+        slot = (slot + 1) & state->mask;
     }
 }
 
-void reduce(mafsa_builder *m)
+static int reduce(mafsa_builder *m)
 {
-    int ret;
-    khiter_t k;
     reduce_state state;
-
-    kv_init(state.reg);
-    state.rep = kh_init(m32);
+    uint nslots = 2;
+    while (nslots < 2 * (uint)m->size) {
+        nslots *= 2;
+    }
+    state.mask = nslots - 1;
+    state.reg  = calloc(nslots, sizeof(*state.reg));
+    state.rep  = calloc((size_t)m->size, sizeof(*state.rep));
+    if (!state.reg || !state.rep) {
+        free(state.reg);
+        free(state.rep);
+        return -1;
+    }
     visit_post(m, 0, &state);
+    free(state.reg);
 
-    // re-number states
-    // TODO: use flat array instead of hash table
+    // re-number states, conv[old] = new
+    int *conv = state.rep; // reuse: only needed for live states from here on
     int new_size = 0;
-    ht_t *conv  = kh_init(m32);
-    ht_t *rconv = kh_init(m32);
     for (int i = 0; i < m->size; i++) {
-        if (kh_get(m32, state.rep, i) != kh_end(state.rep)) {  // dead node
+        if (i != 0 && state.rep[i] != i) {  // dead or unreachable node
+            conv[i] = -1;
             continue;
         }
-        k = kh_put(m32, conv, i, &ret);
-        assert(ret != 0); // TODO: handle error
-        kh_value(conv, k) = new_size;
-        k = kh_put(m32, rconv, new_size, &ret);
-        assert(ret != 0); // TODO: handle error
-        kh_value(rconv, k) = i;
-        ++new_size;
-    }
-    kh_destroy(m32, state.rep);
-    kv_destroy(state.reg);
-
-    node *new_nodes = malloc(sizeof(*new_nodes) * new_size);
-    int  *new_terms = malloc(sizeof(*new_terms) * new_size);
-    memset(new_nodes, 0, sizeof(*new_nodes) * new_size);
-    memset(new_terms, 0, sizeof(*new_terms) * new_size);
-    assert(new_nodes != NULL); // TODO: handle error
-    for (int i = 0; i < new_size; ++i) {
-        assert(kh_get(m32, rconv, i) != kh_end(rconv));
-        const int newidx = i;
-        const int oldidx = kh_value(rconv, kh_get(m32, rconv, newidx));
-        new_terms[newidx] = m->terms[oldidx];
-        for (int child = 0; child < 26; ++child) {
-            const int old_t = m->nodes[oldidx].children[child];
+        conv[i] = new_size++;
+    }
+
+    node *new_nodes = calloc((size_t)new_size, sizeof(*new_nodes));
+    int  *new_terms = calloc((size_t)new_size, sizeof(*new_terms));
+    if (!new_nodes || !new_terms) {
+        free(new_nodes);
+        free(new_terms);
+        free(conv);
+        return -1;
+    }
+    for (int i = 0; i < m->size; ++i) {
+        const int newidx = conv[i];
+        if (newidx < 0) {
+            continue;
+        }
+        new_terms[newidx] = m->terms[i];
+        for (int child = 0; child < MAFSA_NEDGES; ++child) {
+            const int old_t = m->nodes[i].children[child];
             if (old_t == 0) {
                 continue;
             }
-            assert(kh_get(m32, conv, old_t) != kh_end(conv));
-            const int new_t = kh_value(conv, kh_get(m32, conv, old_t));
-            new_nodes[newidx].children[child] = new_t;
+            assert(conv[old_t] > 0);
+            new_nodes[newidx].children[child] = conv[old_t];
         }
     }
-    kh_destroy(m32, conv);
-    kh_destroy(m32, rconv);
+    free(conv);
 
     free(m->nodes);
     free(m->terms);
@@ -206,32 +257,128 @@ void reduce(mafsa_builder *m)
     m->terms = new_terms;
     m->size  = new_size;
     m->capacity = new_size;
+    return 0;
+}
+
+int mafsa_builder_minimize(mafsa_builder *m)
+{
+    return reduce(m);
+}
+
+int mafsa_builder_merge(mafsa_builder *m, mafsa_builder *shards, int nshards)
+{
+    int rc;
+    size_t total = (size_t)m->size;
+    for (int k = 0; k < nshards; ++k) {
+        const node *root = &shards[k].nodes[0];
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            if (root->children[c] != 0 && m->nodes[0].children[c] != 0) {
+                return -1;
+            }
+        }
+        total += (size_t)shards[k].size;
+    }
+    if (total > (size_t)m->capacity) {
+        TRY(expand(m, total - (size_t)m->capacity));
+    }
+
+    // shard roots are copied too, they're unreachable and get dropped by
+    // the next reduce()
+    for (int k = 0; k < nshards; ++k) {
+        mafsa_builder *shard = &shards[k];
+        const int base = m->size;
+        for (int i = 0; i < shard->size; ++i) {
+            node *n = &m->nodes[base + i];
+            for (int c = 0; c < MAFSA_NEDGES; ++c) {
+                const int t = shard->nodes[i].children[c];
+                n->children[c] = t != 0 ? base + t : 0;
+            }
+            m->terms[base + i] = shard->terms[i];
+        }
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            if (shard->nodes[0].children[c] != 0) {
+                m->nodes[0].children[c] = m->nodes[base].children[c];
+            }
+        }
+        m->terms[0] |= shard->terms[0];
+        m->size += shard->size;
+        free(shard->nodes);
+        free(shard->terms);
+        shard->nodes = NULL;
+        shard->terms = NULL;
+        shard->size  = 0;
+        shard->capacity = 0;
+    }
+    return 0;
+}
+
+#define REACH_DONE (1u << 31)
+
+// the lexicons with a word at or below `s`, memoized in `reach`
+static uint reach_of(const mafsa_builder *m, uint *reach, int s)
+{
+    if ((reach[s] & REACH_DONE) == 0) {
+        uint result = (uint)m->terms[s];
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            const int t = m->nodes[s].children[c];
+            if (t != 0) {
+                result |= reach_of(m, reach, t);
+            }
+        }
+        reach[s] = result | REACH_DONE;
+    }
+    return reach[s] & ~REACH_DONE;
 }
 
 int mafsa_builder_finish(mafsa_builder *m, mafsa *out)
 {
-    reduce(m);
-    size_t size  = (size_t)m->size;
-    node  *nodes = malloc(sizeof(*nodes) * size);
-    uint  *terms = malloc(size + sizeof(*terms));
-    if (!nodes || !terms) {
-        free(nodes);
-        free(terms);
+    int rc;
+    TRY(reduce(m));
+    const int size = m->size;
+    // offset of each state in the packed array; states keep their order
+    int  *offsets = malloc(sizeof(*offsets) * (size_t)size);
+    uint *reach   = calloc((size_t)size, sizeof(*reach));
+    if (!offsets || !reach) {
+        free(offsets);
+        free(reach);
         return -1;
     }
-    memset(nodes, 0, sizeof(*nodes) * size);
-    memset(terms, 0, size + sizeof(*terms));
-    for (size_t i = 0; i < size; ++i) {
-        memcpy(&nodes[i], &m->nodes[i], sizeof(*nodes));
-        size_t entry = (size_t)i / sizeof(uint);
-        size_t shift = (size_t)i % sizeof(uint);
-        uint   tbit  = m->terms[i] ? 1u : 0u;
-        // printf("i=%zu entry=%zu shift=%zu size=%zu\n", i, entry, shift, size);
-        terms[entry] |= tbit << shift;
-    }
-    out->nodes = nodes;
-    out->terms = terms;
-    out->size  = m->size;
+    size_t length = 0;
+    for (int i = 0; i < size; ++i) {
+        offsets[i] = (int)length++;
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            length += m->nodes[i].children[c] != 0 ? 1 : 0;
+        }
+        if (length > (size_t)MAFSA_OFFSET + 1) {
+            free(offsets);
+            free(reach);
+            return -1;
+        }
+    }
+    uint *data = malloc(sizeof(*data) * length);
+    if (!data) {
+        free(offsets);
+        free(reach);
+        return -1;
+    }
+    for (int i = 0; i < size; ++i) {
+        uint *p     = &data[offsets[i]];
+        uint  terms = (uint)m->terms[i];
+        uint  edges = (terms << MAFSA_LEXSHIFT) | (terms != 0 ? MAFSA_TERM : 0u);
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            const int t = m->nodes[i].children[c];
+            if (t != 0) {
+                edges |= 1u << c;
+                *++p = (uint)offsets[t] | (reach_of(m, reach, t) << MAFSA_LEXSHIFT);
+            }
+        }
+        data[offsets[i]] = edges;
+    }
+    free(offsets);
+    free(reach);
+    out->data    = data;
+    out->size    = (int)length;
+    out->nstates = size;
     free(m->nodes);
     free(m->terms);
     m->nodes = NULL;
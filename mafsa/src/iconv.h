@@ -10,7 +10,7 @@ static const int iconv_table[128] = {
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
     -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
     -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
-    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, 26, -1,
     -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
     15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, -1, -1, -1, -1, -1,
 };
@@ -28,7 +28,7 @@ static const int sconv_table[128] = {
 
 static inline int iconv(char c) {
 #ifndef NDEBUG
-    assert(('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z'));
+    assert(('A' <= c && c <= 'Z') || ('a' <= c && c <= 'z') || c == '^');
     return iconv_table[(unsigned char)(c & 0x7Fu)];
 #else
     return iconv_table[(unsigned char)(c)];
@@ -5,79 +5,171 @@
 #include <stddef.h>
 #include "iconv.h"
 
-#include <stdio.h> // TEMP TEMP
 
 typedef unsigned int uint;
-typedef mafsa_node_  node;
 
-int isterm(const uint* terms, int s)
+static const uint LETTERS = (1u << 26) - 1u;
+
+static int popcount(uint x)
 {
-    assert(0 <= s);
-    size_t entry = (size_t)s / sizeof(uint);
-    size_t shift = (size_t)s % sizeof(uint);
-    uint   mask  = 1u << shift;
-    return ((terms[entry] & mask) != 0) ? 1 : 0;
+#ifdef __POPCNT__
+    return __builtin_popcount(x);
+#else
+    // without hardware popcnt the builtin is a libgcc call
+    x = x - ((x >> 1) & 0x55555555u);
+    x = (x & 0x33333333u) + ((x >> 2) & 0x33333333u);
+    x = (x + (x >> 4)) & 0x0F0F0F0Fu;
+    return (int)((x * 0x01010101u) >> 24);
+#endif
 }
 
-int mafsa_isterm(const mafsa *m, int s)
+// returns the child of `s` on edge `c`, or 0 if there is no such edge
+static int next_state(const uint *data, int s, int c)
 {
-    if (!(0 <= s && s < m->size)) {
+    const uint edges = data[s];
+    const uint bit   = 1u << c;
+    if ((edges & bit) == 0) {
         return 0;
     }
-    return isterm(m->terms, s);
+    return (int)(data[s + 1 + popcount(edges & (bit - 1))] & MAFSA_OFFSET);
 }
 
-int mafsa_isword(const struct mafsa *m, const char *const word)
+// returns the state reached from the root on `word`, or -1
+static int walk(const uint *data, const char *const word)
 {
-    // printf("ISWORD: '%s'\n", word);
-    const node *nodes = m->nodes;
-    const int   size  = m->size;
     int s = 0;
     for (const char *p = word; *p != '\0'; ++p) {
         const int c = iconv(*p);
-        const int t = nodes[s].children[c];
-        assert(0 <= s && s < size);
-        assert(0 <= c && c <= 26);
-        // printf("\tch=%c c=%d t=%d\n", *p, c, t);
+        assert(0 <= c && c < MAFSA_NEDGES);
+        const int t = next_state(data, s, c);
         if (t == 0) {
-            return 0;
+            return -1;
         }
         s = t;
     }
-    // printf("Leaving term[%d] = %d (0x%08x)\n", s, isterm(m->terms, s), m->terms[s/sizeof(uint)]);
-    return isterm(m->terms, s);
+    return s;
 }
 
-void mafsa_free(mafsa *m)
+static uint lexicon_bit(int lexicon)
 {
-    free(m->nodes);
-    free(m->terms);
-    m->nodes = NULL;
-    m->terms = NULL;
-    m->size  = 0;
+    assert(0 <= lexicon && lexicon < MAFSA_MAX_LEXICONS);
+    return 1u << (MAFSA_LEXSHIFT + lexicon);
 }
 
-mafsa_edges mafsa_prefix_edges(const mafsa *m, const char *const word)
+static mafsa_edges make_edges(uint mask)
 {
     mafsa_edges result;
-    const node *nodes = m->nodes;
-    const int   size  = m->size;
-    int s = 0;
     memset(&result, 0, sizeof(result));
+    result.terminal = (mask & MAFSA_TERM) != 0 ? 1 : 0;
+    int ntiles = 0;
+    for (uint edges = mask & LETTERS; edges != 0; edges &= edges - 1) {
+        result.edges[ntiles++] = (char)(__builtin_ctz(edges) + 'A');
+    }
+    return result;
+}
+
+int mafsa_isterm(const mafsa *m, int s)
+{
+    if (!(0 <= s && s < m->size)) {
+        return 0;
+    }
+    return (m->data[s] & MAFSA_TERM) != 0 ? 1 : 0;
+}
+
+int mafsa_isword(const struct mafsa *m, const char *const word)
+{
+    const uint *data = m->data;
+    int s = 0;
     for (const char *p = word; *p != '\0'; ++p) {
         const int c = iconv(*p);
-        const int t = nodes[s].children[c];
+        assert(0 <= s && s < m->size);
+        assert(0 <= c && c < MAFSA_NEDGES);
+        const int t = next_state(data, s, c);
         if (t == 0) {
-            return result;
+            return 0;
         }
         s = t;
     }
-    result.terminal = isterm(m->terms, s);
-    int ntiles = 0;
-    for (int i = 0; i < 26; ++i) {
-        if (nodes[s].children[i] != 0) {
-            result.edges[ntiles++] = (char)(i + 'A');
+    return (data[s] & MAFSA_TERM) != 0 ? 1 : 0;
+}
+
+void mafsa_free(mafsa *m)
+{
+    free(m->data);
+    m->data    = NULL;
+    m->size    = 0;
+    m->nstates = 0;
+}
+
+unsigned int mafsa_prefix_mask(const mafsa *m, const char *const word)
+{
+    const int s = walk(m->data, word);
+    return s < 0 ? 0u : m->data[s] & (LETTERS | MAFSA_TERM);
+}
+
+mafsa_edges mafsa_prefix_edges(const mafsa *m, const char *const word)
+{
+    return make_edges(mafsa_prefix_mask(m, word));
+}
+
+int mafsa_root(const mafsa *m)
+{
+    (void)m;
+    return 0;
+}
+
+int mafsa_child(const mafsa *m, int s, int c)
+{
+    assert(0 <= s && s < m->size);
+    assert(0 <= c && c < MAFSA_NEDGES);
+    return next_state(m->data, s, c);
+}
+
+unsigned int mafsa_edgemask(const mafsa *m, int s)
+{
+    assert(0 <= s && s < m->size);
+    return m->data[s] & MAFSA_EDGES;
+}
+
+int mafsa_isterm_in(const mafsa *m, int s, int lexicon)
+{
+    if (!(0 <= s && s < m->size)) {
+        return 0;
+    }
+    return (m->data[s] & lexicon_bit(lexicon)) != 0 ? 1 : 0;
+}
+
+int mafsa_isword_in(const mafsa *m, const char *const word, int lexicon)
+{
+    const int s = walk(m->data, word);
+    return s >= 0 && (m->data[s] & lexicon_bit(lexicon)) != 0 ? 1 : 0;
+}
+
+unsigned int mafsa_edgemask_in(const mafsa *m, int s, int lexicon)
+{
+    assert(0 <= s && s < m->size);
+    const uint  bit   = lexicon_bit(lexicon);
+    const uint  edges = m->data[s] & MAFSA_EDGES;
+    const uint *child = &m->data[s + 1];
+    uint result = 0;
+    for (int c = 0; c < MAFSA_NEDGES; ++c) {
+        if ((edges & (1u << c)) != 0 && (*child++ & bit) != 0) {
+            result |= 1u << c;
         }
     }
     return result;
 }
+
+unsigned int mafsa_prefix_mask_in(const mafsa *m, const char *const word, int lexicon)
+{
+    const int s = walk(m->data, word);
+    if (s < 0) {
+        return 0u;
+    }
+    return (mafsa_edgemask_in(m, s, lexicon) & LETTERS) | (mafsa_isterm_in(m, s, lexicon) ? MAFSA_TERM : 0u);
+}
+
+mafsa_edges mafsa_prefix_edges_in(const mafsa *m, const char *const word, int lexicon)
+{
+    return make_edges(mafsa_prefix_mask_in(m, word, lexicon));
+}
@@ -0,0 +1,337 @@
+#include "datrie.h"
+#include "native_file.h"
+#include <algorithm>
+#include <cassert>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+#include <utility>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// see native_file.h, followed by the state and slot arrays
+constexpr char     kNativeMagic[8] = { 'D', 'A', 'T', 'R', 'I', 'E', 'B', 'N' };
+constexpr uint32_t kNativeVersion  = 1;
+
+int letter(char ch) noexcept
+{
+    if ('A' <= ch && ch <= 'Z') {
+        return ch - 'A';
+    } else if ('a' <= ch && ch <= 'z') {
+        return ch - 'a';
+    } else if (ch == '^') {
+        return MAFSA_SEP;
+    }
+    return -1;
+}
+
+// Hands out bases for states, first fit. Used slots are kept in a bitmap so
+// that 64 candidate bases are tested at once: a base `b` fits a state if slot
+// `b + c` is free for each of its edges `c`. Everything before `head_` is
+// full. States arrive sorted by degree, and a search resumes where the last
+// one for the same degree succeeded: it may skip some holes, but those get
+// filled by the smaller states that follow. A search that finds nothing
+// within `kMaxScan` words places the state at the end.
+class SlotAllocator
+{
+public:
+    int size() const noexcept { return size_; }
+
+    int place(uint32_t edges)
+    {
+        const int degree = __builtin_popcount(edges);
+        if (degree != degree_) {
+            degree_ = degree;
+            hint_   = head_;
+        }
+        const std::size_t end = static_cast<std::size_t>(size_) / 64;
+        std::size_t w = std::max(head_, hint_);
+        for (std::size_t scanned = 0; w <= end; ++w, ++scanned) {
+            if (scanned == kMaxScan) {
+                w = end;
+            }
+            const std::uint64_t fits = candidates(w, edges);
+            if (fits != 0) {
+                hint_ = w;
+                const int base = static_cast<int>(64 * w) + __builtin_ctzll(fits);
+                occupy(base, edges);
+                return base;
+            }
+        }
+        // unreachable: everything past `size_` is free
+        const int base = size_;
+        occupy(base, edges);
+        return base;
+    }
+
+private:
+    static constexpr std::size_t kMaxScan = 1 << 10;
+
+    std::uint64_t word(std::size_t w) const noexcept
+    {
+        return w < used_.size() ? used_[w] : 0;
+    }
+
+    // bit `i` is set if base `64 * w + i` fits
+    std::uint64_t candidates(std::size_t w, uint32_t edges) const noexcept
+    {
+        const std::uint64_t lo = word(w);
+        const std::uint64_t hi = word(w + 1);
+        std::uint64_t result = ~std::uint64_t{0};
+        while (edges != 0 && result != 0) {
+            const int c = __builtin_ctz(edges);
+            edges &= edges - 1;
+            const std::uint64_t used = c == 0 ? lo : (lo >> c) | (hi << (64 - c));
+            result &= ~used;
+        }
+        return result;
+    }
+
+    void occupy(int base, uint32_t edges)
+    {
+        // keep every base + letter in range so lookups don't bounds check
+        size_ = std::max(size_, base + MAFSA_NEDGES);
+        used_.resize(static_cast<std::size_t>(size_) / 64 + 1, 0);
+        while (edges != 0) {
+            const auto t = static_cast<std::size_t>(base + __builtin_ctz(edges));
+            edges &= edges - 1;
+            used_[t / 64] |= std::uint64_t{1} << (t % 64);
+        }
+        while (head_ < used_.size() && used_[head_] == ~std::uint64_t{0}) {
+            ++head_;
+        }
+    }
+
+    std::vector<std::uint64_t> used_;
+    std::size_t                head_   = 0;
+    std::size_t                hint_   = 0;
+    int                        degree_ = 0;
+    int                        size_   = 0;
+};
+
+cicero_node lexicon_root(const void* data)
+{
+    return reinterpret_cast<const DATrie*>(data)->root();
+}
+
+cicero_node lexicon_child(const void* data, cicero_node node, int letter)
+{
+    return reinterpret_cast<const DATrie*>(data)->child(node, letter);
+}
+
+uint32_t lexicon_edges(const void* data, cicero_node node)
+{
+    const auto* self = reinterpret_cast<const DATrie*>(data);
+    return self->edges(node) | (self->isterm(node) ? CICERO_TERMINAL : 0u);
+}
+
+} // ~namespace
+
+DATrie::DATrie(DATrie&& other) noexcept
+    : state_storage_{std::move(other.state_storage_)}
+    , slot_storage_{std::move(other.slot_storage_)}
+    , states_{other.states_}
+    , slots_{other.slots_}
+    , nstates_{other.nstates_}
+    , nslots_{other.nslots_}
+    , mapping_{other.mapping_}
+    , mapping_size_{other.mapping_size_}
+{
+    other.states_       = nullptr;
+    other.slots_        = nullptr;
+    other.nstates_      = 0;
+    other.nslots_       = 0;
+    other.mapping_      = nullptr;
+    other.mapping_size_ = 0;
+}
+
+DATrie::~DATrie() noexcept
+{
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    }
+}
+
+std::optional<DATrie> DATrie::build(const Mafsa& m)
+{
+    // number the MA-FSA's states densely, in order so the root stays 0
+    std::vector<int> ids(static_cast<std::size_t>(m->size), -1);
+    std::vector<int> offsets;
+    for (int s = 0; s < m->size; s += 1 + __builtin_popcount(m.edges(s))) {
+        ids[static_cast<std::size_t>(s)] = static_cast<int>(offsets.size());
+        offsets.push_back(s);
+    }
+    const auto nstates = offsets.size();
+
+    // states with the most edges are the hardest to fit, place them first
+    std::vector<int> order(nstates);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+        return __builtin_popcount(m.edges(offsets[static_cast<std::size_t>(a)])) >
+               __builtin_popcount(m.edges(offsets[static_cast<std::size_t>(b)]));
+    });
+
+    DATrie result;
+    result.state_storage_.assign(nstates, State{0, 0});
+    SlotAllocator slots;
+    for (int id : order) {
+        const int s = offsets[static_cast<std::size_t>(id)];
+        const uint32_t edges = m.edges(s);
+        auto& state = result.state_storage_[static_cast<std::size_t>(id)];
+        state.info = edges | (m.isterm(s) ? MAFSA_TERM : 0u);
+        state.base = edges != 0 ? slots.place(edges) : 0;
+    }
+
+    result.slot_storage_.assign(static_cast<std::size_t>(std::max(slots.size(), MAFSA_NEDGES)), Slot{-1, -1});
+    for (std::size_t id = 0; id < nstates; ++id) {
+        const int s = offsets[id];
+        const auto& state = result.state_storage_[id];
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            if ((state.info & (1u << c)) != 0) {
+                auto& slot = result.slot_storage_[static_cast<std::size_t>(state.base + c)];
+                assert(slot.check == -1);
+                slot.check = static_cast<std::int32_t>(id);
+                slot.next  = ids[static_cast<std::size_t>(m.child(s, c))];
+            }
+        }
+    }
+
+    result.states_  = result.state_storage_.data();
+    result.slots_   = result.slot_storage_.data();
+    result.nstates_ = static_cast<int>(result.state_storage_.size());
+    result.nslots_  = static_cast<int>(result.slot_storage_.size());
+    return result;
+}
+
+int DATrie::next_state(int s, char ch) const noexcept
+{
+    const int c = letter(ch);
+    if (c < 0) {
+        return -1;
+    }
+    const Slot& slot = slots_[states_[s].base + c];
+    return slot.check == s ? slot.next : -1;
+}
+
+bool DATrie::isword(const char* word) const noexcept
+{
+    int s = 0;
+    for (const char* p = word; *p != '\0'; ++p) {
+        s = next_state(s, *p);
+        if (s < 0) {
+            return false;
+        }
+    }
+    return isterm(s);
+}
+
+mafsa_edges DATrie::get_edges(const char* const word) const noexcept
+{
+    mafsa_edges result;
+    memset(&result, 0, sizeof(result));
+    int s = 0;
+    for (const char* p = word; *p != '\0'; ++p) {
+        s = next_state(s, *p);
+        if (s < 0) {
+            return result;
+        }
+    }
+    result.terminal = isterm(s) ? 1 : 0;
+    int ntiles = 0;
+    for (int i = 0; i < 26; ++i) {
+        if ((states_[s].info & (1u << i)) != 0) {
+            result.edges[ntiles++] = static_cast<char>(i + 'A');
+        }
+    }
+    return result;
+}
+
+cicero_lexicon DATrie::lexicon() const noexcept
+{
+    cicero_lexicon result;
+    result.root   = &lexicon_root;
+    result.child  = &lexicon_child;
+    result.edges  = &lexicon_edges;
+    result.data   = this;
+    return result;
+}
+
+std::size_t DATrie::bytes() const noexcept
+{
+    return sizeof(State) * static_cast<std::size_t>(nstates_) + sizeof(Slot) * static_cast<std::size_t>(nslots_);
+}
+
+bool DATrie::save(const std::string& filename, MafsaType type) const
+{
+    NativeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kNativeMagic, sizeof(header.magic));
+    header.version    = kNativeVersion;
+    header.byte_order = kByteOrderMark;
+    header.type       = native_type(type);
+    header.nstates    = static_cast<uint32_t>(nstates_);
+    header.count      = static_cast<uint64_t>(nslots_);
+
+    return write_replacing(filename, {
+        { &header, sizeof(header) },
+        { states_, sizeof(State) * static_cast<std::size_t>(nstates_) },
+        { slots_, sizeof(Slot) * static_cast<std::size_t>(nslots_) },
+    });
+}
+
+std::optional<DATrie> DATrie::load(const std::string& filename, MafsaType type)
+{
+    const int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "error: unable to open dictionary file: " << filename << "\n";
+        return std::nullopt;
+    }
+    struct stat st;
+    NativeHeader header;
+    if (fstat(fd, &st) != 0 ||
+        pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+        memcmp(header.magic, kNativeMagic, sizeof(header.magic)) != 0) {
+        std::cerr << "error: not a double-array dictionary file: " << filename << "\n";
+        close(fd);
+        return std::nullopt;
+    }
+    const auto length = static_cast<std::size_t>(st.st_size);
+    const char* error = nullptr;
+    if (header.byte_order != kByteOrderMark) {
+        error = "dictionary file was written with a different byte order";
+    } else if (header.version != kNativeVersion) {
+        error = "unsupported dictionary file version";
+    } else if (header.type != native_type(type)) {
+        error = header.type == 1 ? "dictionary file is a GADDAG" : "dictionary file is a DAWG";
+    } else if (header.nstates == 0 || header.nstates > INT_MAX ||
+               header.count < MAFSA_NEDGES || header.count > INT_MAX ||
+               length != sizeof(header) + sizeof(State) * header.nstates + sizeof(Slot) * header.count) {
+        error = "truncated or corrupt dictionary file";
+    }
+    if (error) {
+        std::cerr << "error: " << error << "\n";
+        close(fd);
+        return std::nullopt;
+    }
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "error: unable to map dictionary file\n";
+        return std::nullopt;
+    }
+    const char* data = static_cast<const char*>(mapping) + sizeof(header);
+    DATrie result;
+    result.states_       = reinterpret_cast<const State*>(data);
+    result.slots_        = reinterpret_cast<const Slot*>(data + sizeof(State) * header.nstates);
+    result.nstates_      = static_cast<int>(header.nstates);
+    result.nslots_       = static_cast<int>(header.count);
+    result.mapping_      = mapping;
+    result.mapping_size_ = length;
+    return result;
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include <mafsa/mafsa.h>
+#include <cicero/cicero.h>
+#include "mafsa++.h"
+
+// Double-array lexicon: the transition from state `s` on letter `c` is slot
+// `base[s] + c`, valid if that slot's `check` is `s`. Built from a minimized
+// MA-FSA (DAWG or GADDAG) so states with the same suffixes are shared, and
+// offers the same lookup interface as `Mafsa`, so cicero can run on either.
+struct DATrie
+{
+    struct State
+    {
+        std::int32_t  base;
+        std::uint32_t info; // edge mask, MAFSA_TERM if terminal
+    };
+
+    struct Slot
+    {
+        std::int32_t check; // owning state, -1 if unused
+        std::int32_t next;
+    };
+
+    DATrie(DATrie&& other) noexcept;
+    DATrie& operator=(DATrie&&) = delete;
+    DATrie(const DATrie&) = delete;
+    DATrie& operator=(const DATrie&) = delete;
+    ~DATrie() noexcept;
+
+    static std::optional<DATrie> build(const Mafsa& m);
+    // reads the native format written by `save`, mmap'd read-only
+    static std::optional<DATrie> load(const std::string& filename, MafsaType type=MafsaType::eDawg);
+    bool save(const std::string& filename, MafsaType type=MafsaType::eDawg) const;
+
+    bool isword(const char* word) const noexcept;
+    bool isword(const std::string& word) const noexcept { return isword(word.c_str()); }
+    bool isterm(int s) const noexcept { return (states_[s].info & MAFSA_TERM) != 0; }
+    mafsa_edges get_edges(const char* const word) const noexcept;
+    mafsa_edges get_edges(const std::string& word) const noexcept { return get_edges(word.c_str()); }
+    int root() const noexcept { return 0; }
+    // precondition: `c` is set in edges(s)
+    int child(int s, int c) const noexcept { return slots_[states_[s].base + c].next; }
+    unsigned int edges(int s) const noexcept { return states_[s].info & MAFSA_EDGES; }
+    // only valid as long as this object isn't moved or destroyed
+    cicero_lexicon lexicon() const noexcept;
+
+    int num_states() const noexcept { return nstates_; }
+    int num_slots() const noexcept { return nslots_; }
+    std::size_t bytes() const noexcept;
+
+private:
+    DATrie() = default;
+    // returns the state reached from `s` on `ch`, or -1
+    int next_state(int s, char ch) const noexcept;
+
+    std::vector<State> state_storage_;
+    std::vector<Slot>  slot_storage_;
+    const State*       states_       = nullptr;
+    const Slot*        slots_        = nullptr;
+    int                nstates_      = 0;
+    int                nslots_       = 0;
+    void*              mapping_      = nullptr;
+    std::size_t        mapping_size_ = 0;
+};
@@ -0,0 +1,135 @@
+#include "hooks.h"
+#include <climits>
+
+namespace {
+
+// # of words at or below `s`, memoized in `count` (UINT32_MAX = not yet)
+std::uint32_t count_words(const mafsa& m, int s, std::vector<std::uint32_t>& count)
+{
+    auto& result = count[static_cast<std::size_t>(s)];
+    if (result == UINT32_MAX) {
+        std::uint32_t n = (m.data[s] & MAFSA_TERM) != 0 ? 1u : 0u;
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            if ((mafsa_edgemask(&m, s) & (1u << c)) != 0) {
+                n += count_words(m, mafsa_child(&m, s, c), count);
+            }
+        }
+        result = n;
+    }
+    return result;
+}
+
+} // ~namespace
+
+HookIndex HookIndex::build(const Mafsa& dawg, int lexicon_id)
+{
+    HookIndex result{dawg, lexicon_id};
+    const mafsa& m = *dawg;
+    const auto size = static_cast<std::size_t>(m.size);
+
+    // a child entry skips the words ending at its state and the words below
+    // its earlier siblings
+    std::vector<std::uint32_t> count(size, UINT32_MAX);
+    result.skip_.assign(size, 0u);
+    for (int s = 0; s < m.size; s += 1 + __builtin_popcount(mafsa_edgemask(&m, s))) {
+        std::uint32_t before = (m.data[s] & MAFSA_TERM) != 0 ? 1u : 0u;
+        int e = s + 1;
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            if ((mafsa_edgemask(&m, s) & (1u << c)) != 0) {
+                result.skip_[static_cast<std::size_t>(e++)] = before;
+                before += count_words(m, mafsa_child(&m, s, c), count);
+            }
+        }
+    }
+    result.hooks_.assign(count_words(m, 0, count), Hooks{0u, 0u});
+
+    // every word of the lexicon is a front hook of its tail and a back hook
+    // of its head
+    char word[16];
+    auto visit = [&](auto&& self, int s, int len) -> void {
+        if (len >= 2 && result.isterm(s)) {
+            const std::uint32_t first = 1u << (word[0] - 'A');
+            const std::uint32_t last  = 1u << (word[len - 1] - 'A');
+            if (len == 2) {
+                result.letters_[static_cast<std::size_t>(word[1] - 'A')].front |= first;
+                result.letters_[static_cast<std::size_t>(word[0] - 'A')].back  |= last;
+            } else {
+                const long tail = result.rank(word + 1, len - 1);
+                if (tail >= 0) {
+                    result.hooks_[static_cast<std::size_t>(tail)].front |= first;
+                }
+                const long head = result.rank(word, len - 1);
+                if (head >= 0) {
+                    result.hooks_[static_cast<std::size_t>(head)].back |= last;
+                }
+            }
+        }
+        for (int c = 0; c < 26 && len < 15; ++c) {
+            if ((mafsa_edgemask(&m, s) & (1u << c)) != 0) {
+                word[len] = static_cast<char>('A' + c);
+                self(self, mafsa_child(&m, s, c), len + 1);
+            }
+        }
+    };
+    visit(visit, 0, 0);
+    return result;
+}
+
+bool HookIndex::isterm(int s) const noexcept
+{
+    return lexicon_id_ < 0 ? dawg_->isterm(s) : dawg_->isterm(s, lexicon_id_);
+}
+
+long HookIndex::rank(const char* word, int len) const noexcept
+{
+    const unsigned int* data = (*dawg_)->data;
+    long result = 0;
+    int s = 0;
+    for (int i = 0; i < len; ++i) {
+        const unsigned int c = static_cast<unsigned int>(word[i] - 'A');
+        const unsigned int bit = 1u << c;
+        if (c >= 26 || (data[s] & bit) == 0) {
+            return -1;
+        }
+        const int e = s + 1 + __builtin_popcount(data[s] & MAFSA_EDGES & (bit - 1));
+        result += skip_[static_cast<std::size_t>(e)];
+        s = static_cast<int>(data[e] & MAFSA_OFFSET);
+    }
+    return (data[s] & MAFSA_TERM) != 0 ? result : -1;
+}
+
+bool HookIndex::lookup(const char* word, int len, Hooks& out) const noexcept
+{
+    if (len == 1) {
+        const unsigned int c = static_cast<unsigned int>(word[0] - 'A');
+        if (c >= 26) {
+            return false;
+        }
+        out = letters_[c];
+        return true;
+    }
+    // hooks are kept for all the DAWG's words, a word of another lexicon can
+    // still be hooked into this one
+    const long r = rank(word, len);
+    if (r < 0) {
+        return false;
+    }
+    out = hooks_[static_cast<std::size_t>(r)];
+    return true;
+}
+
+int HookIndex::cicero_hooks(const void* data, const char* word, int len, std::uint32_t* front, std::uint32_t* back)
+{
+    Hooks hooks;
+    if (!reinterpret_cast<const HookIndex*>(data)->lookup(word, len, hooks)) {
+        return 0;
+    }
+    *front = hooks.front;
+    *back  = hooks.back;
+    return 1;
+}
+
+std::size_t HookIndex::bytes() const noexcept
+{
+    return skip_.size() * sizeof(skip_[0]) + hooks_.size() * sizeof(hooks_[0]) + sizeof(letters_);
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <cicero/cicero.h>
+#include "mafsa++.h"
+
+// Front and back hooks of every word in a DAWG: the letters that can be put
+// in front of or behind it to make another word. Words are numbered by their
+// rank in the DAWG, which is summed up while walking the word, so a lookup is
+// one walk plus one table read instead of a walk per letter.
+struct HookIndex
+{
+    struct Hooks
+    {
+        std::uint32_t front; // bit i set if 'A' + i can be put in front
+        std::uint32_t back;
+    };
+
+    // `dawg` must outlive the index. With `lexicon_id` >= 0 only the words of
+    // that lexicon count, as with Mafsa::lexicon(lexicon_id).
+    static HookIndex build(const Mafsa& dawg, int lexicon_id=-1);
+
+    // false if `word` isn't a word; single letters are always known
+    bool lookup(const char* word, int len, Hooks& out) const noexcept;
+
+    // cicero_callbacks::hooks, `data` is the HookIndex
+    static int cicero_hooks(const void* data, const char* word, int len, std::uint32_t* front, std::uint32_t* back);
+
+    std::size_t num_words() const noexcept { return hooks_.size(); }
+    std::size_t bytes() const noexcept;
+
+private:
+    HookIndex(const Mafsa& dawg, int lexicon_id) noexcept : dawg_{&dawg}, lexicon_id_{lexicon_id} {}
+    bool isterm(int s) const noexcept;
+    // rank of `word` among all the words of the DAWG, -1 if it isn't one
+    long rank(const char* word, int len) const noexcept;
+
+    const Mafsa*               dawg_;
+    int                        lexicon_id_;
+    std::vector<std::uint32_t> skip_;  // by child entry: # of words before the child's first word
+    std::vector<Hooks>         hooks_; // by rank
+    std::array<Hooks, 26>      letters_{};
+};
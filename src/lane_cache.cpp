@@ -0,0 +1,133 @@
+#include "lane_cache.h"
+#include <cstddef>
+#include <cstring>
+
+namespace {
+
+bool is_anchor(const cicero* e, int sq) noexcept
+{
+    return (e->asqs[sq / 64] & (1ull << (sq % 64))) != 0;
+}
+
+} // ~namespace
+
+LaneMoveCache::LaneMoveCache(std::size_t capacity) : capacity_{capacity}, buffer_(1 << 12) {}
+
+bool LaneMoveCache::Key::operator==(const Key& other) const noexcept
+{
+    return std::memcmp(this, &other, sizeof(Key)) == 0;
+}
+
+std::size_t LaneMoveCache::KeyHash::operator()(const Key& key) const noexcept
+{
+    static_assert(sizeof(Key) % sizeof(std::uint64_t) == 0, "Key has to be hashed a word at a time");
+    // FNV-1a, a word at a time
+    std::uint64_t hash = 14695981039346656037ull;
+    const auto* bytes = reinterpret_cast<const char*>(&key);
+    for (std::size_t i = 0; i < sizeof(Key); i += sizeof(std::uint64_t)) {
+        std::uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash ^= word;
+        hash *= 1099511628211ull;
+    }
+    return hash ^ (hash >> 32);
+}
+
+LaneMoveCache::Key LaneMoveCache::make_key(const cicero* e, const cicero_packed_rack& rack, int lane)
+{
+    static_assert(sizeof(Key) == 128, "Key has padding");
+    Key key;
+    std::memset(&key, 0, sizeof(key));
+    key.rack[0]   = rack.counts[0];
+    key.rack[1]   = rack.counts[1];
+    key.rack_mask = rack.mask;
+    key.lane      = static_cast<std::uint8_t>(lane);
+    // vertical moves are generated on the transposed board, see cicero::tvals
+    const bool  vert = lane >= 15;
+    const int   base = (vert ? lane - 15 : lane) * 15;
+    const char* vals = vert ? e->tvals : e->vals;
+    const auto* xchk = vert ? e->tvchk : e->hchk;
+    const auto* xscr = vert ? e->tvscr : e->hscr;
+    for (int i = 0; i < 15; ++i) {
+        key.vals[i] = vals[base + i];
+        key.xchk[i] = xchk[base + i];
+        key.xscr[i] = xscr[base + i];
+        const int sq = vert ? i * 15 + (lane - 15) : base + i;
+        if (is_anchor(e, sq)) {
+            key.anchors |= static_cast<std::uint16_t>(1u << i);
+        }
+    }
+    return key;
+}
+
+void LaneMoveCache::fill(Lane& lane, const cicero* e, cicero_rack rack, int index)
+{
+    const bool vert = index >= 15;
+    for (int i = 0; i < 15; ++i) {
+        lane.begin[static_cast<std::size_t>(i)] = static_cast<std::uint32_t>(lane.moves.size());
+        const int sq = vert ? i * 15 + (index - 15) : index * 15 + i;
+        if (!is_anchor(e, sq)) {
+            continue;
+        }
+        const int item = 2 * sq + (vert ? 1 : 0);
+        cicero_move_sink sink;
+        sink.skip = 0;
+        for (;;) {
+            sink.moves = buffer_.data();
+            sink.cap   = static_cast<int>(buffer_.size());
+            cicero_generate_items_into(e, rack, &item, 1, &sink);
+            if (sink.total <= sink.cap) {
+                break;
+            }
+            buffer_.resize(static_cast<std::size_t>(sink.total));
+        }
+        lane.moves.insert(lane.moves.end(), buffer_.begin(), buffer_.begin() + sink.len);
+    }
+    lane.begin[15] = static_cast<std::uint32_t>(lane.moves.size());
+}
+
+const std::vector<cicero_move_record>& LaneMoveCache::generate(const cicero* e, cicero_rack rack)
+{
+    // make room first, the lanes of this call have to stay put
+    if (lanes_.size() + kLanes > capacity_) {
+        lanes_.clear();
+    }
+    const cicero_packed_rack packed = cicero_pack_rack(&rack);
+    std::array<const Lane*, kLanes> lanes{};
+    for (int index = 0; index < kLanes; ++index) {
+        const Key key = make_key(e, packed, index);
+        if (key.anchors == 0) {
+            continue; // no moves
+        }
+        auto it = lanes_.find(key);
+        if (it != lanes_.end()) {
+            ++stats_.hits;
+        } else {
+            ++stats_.misses;
+            it = lanes_.emplace(key, Lane{}).first;
+            fill(it->second, e, rack, index);
+        }
+        lanes[static_cast<std::size_t>(index)] = &it->second;
+    }
+
+    // the anchors and directions in the order the generator goes through them
+    int items[2 * 225];
+    const int nitems = cicero_move_items(e, items);
+    result_.clear();
+    for (int i = 0; i < nitems; ++i) {
+        const int  sq   = items[i] / 2;
+        const bool vert = items[i] % 2 != 0;
+        const Lane& lane = *lanes[static_cast<std::size_t>(vert ? 15 + sq % 15 : sq / 15)];
+        const std::size_t pos = static_cast<std::size_t>(vert ? sq / 15 : sq % 15);
+        const auto first = lane.moves.begin() + static_cast<std::ptrdiff_t>(lane.begin[pos]);
+        const auto last  = lane.moves.begin() + static_cast<std::ptrdiff_t>(lane.begin[pos + 1]);
+        result_.insert(result_.end(), first, last);
+    }
+    return result_;
+}
+
+void LaneMoveCache::clear() noexcept
+{
+    lanes_.clear();
+    stats_ = Stats{0, 0};
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include <cicero/cicero.h>
+
+// Memo of the legal moves of each of the board's 30 lanes (rows for
+// horizontal moves, columns for vertical ones), for engines that generate
+// moves for the same rack over positions that differ by a move or two, like
+// simulation rollouts or re-analysis in a UI. A lane's moves only depend on
+// its tiles, cross-checks, cross-scores and anchors and on the rack, so that
+// is the key: lanes a move didn't touch come from the memo, and so do the
+// lanes of a position that comes back after cicero_undo_move, without having
+// to be told about moves and undos. The moves come out the same, in the same
+// order, as cicero_generate_legal_moves_into's.
+class LaneMoveCache
+{
+public:
+    struct Stats
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+    };
+
+    // keeps up to `capacity` lanes, starts over once that many are kept
+    explicit LaneMoveCache(std::size_t capacity);
+    LaneMoveCache(const LaneMoveCache&) = delete;
+    LaneMoveCache& operator=(const LaneMoveCache&) = delete;
+
+    // All the legal moves of `rack`, valid until the next call. `e` has to
+    // have the same lexicon and scoring on every call.
+    const std::vector<cicero_move_record>& generate(const cicero* e, cicero_rack rack);
+
+    // forgets all the lanes and resets the counters
+    void clear() noexcept;
+
+    Stats stats() const noexcept { return stats_; }
+    std::size_t size() const noexcept { return lanes_.size(); }
+
+private:
+    static constexpr int kLanes = 30; // rows, then columns
+
+    // the bytes of everything a lane's moves depend on, without padding so
+    // they can be hashed and compared as they are
+    struct Key
+    {
+        std::uint64_t rack[2]; // cicero_packed_rack
+        std::uint32_t xchk[15];
+        std::uint32_t rack_mask;
+        std::uint16_t xscr[15];
+        std::uint16_t anchors; // by square of the lane
+        char          vals[15];
+        std::uint8_t  lane;
+
+        bool operator==(const Key& other) const noexcept;
+    };
+
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const noexcept;
+    };
+
+    struct Lane
+    {
+        std::vector<cicero_move_record> moves;
+        std::array<std::uint32_t, 16>   begin; // moves of the anchor on square i of the lane start here
+    };
+
+    static Key make_key(const cicero* e, const cicero_packed_rack& rack, int lane);
+    void fill(Lane& lane, const cicero* e, cicero_rack rack, int index);
+
+    std::unordered_map<Key, Lane, KeyHash> lanes_;
+    std::size_t                            capacity_;
+    Stats                                  stats_{0, 0};
+    std::vector<cicero_move_record>        buffer_; // for generating a lane's moves
+    std::vector<cicero_move_record>        result_;
+};
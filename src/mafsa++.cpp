@@ -6,11 +6,37 @@
 #include <zlib.h>
 #include <cstring>
 #include <memory>
+#include <vector>
+#include <array>
+#include <numeric>
+#include <algorithm>
+#include <thread>
+#include <utility>
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 #include "mafsa_generated.h"
+#include "native_file.h"
+
+// Native format: see native_file.h, followed by `mafsa::data`
+namespace {
+
+constexpr char     kNativeMagic[8] = { 'M', 'A', 'F', 'S', 'A', 'B', 'I', 'N' };
+constexpr uint32_t kNativeVersion  = 2; // 2: lexicon bits
+
+static_assert(sizeof(unsigned int) == sizeof(uint32_t), "native format assumes 32-bit unsigned int");
+
+} // ~namespace
 
 Mafsa::~Mafsa() noexcept
 {
-    mafsa_free(&mafsa_);
+    if (mapping_) {
+        munmap(mapping_, mapping_size_);
+    } else {
+        mafsa_free(&mafsa_);
+    }
 }
 
 bool Mafsa::isword(const std::string& word) const noexcept
@@ -28,6 +54,69 @@ mafsa_edges Mafsa::get_edges(const char* const word) const noexcept
     return mafsa_prefix_edges(&mafsa_, word);
 }
 
+bool Mafsa::isword(const std::string& word, int lexicon_id) const noexcept
+{
+    return mafsa_isword_in(&mafsa_, word.c_str(), lexicon_id);
+}
+
+bool Mafsa::isterm(int s, int lexicon_id) const noexcept
+{
+    return mafsa_isterm_in(&mafsa_, s, lexicon_id) != 0;
+}
+
+mafsa_edges Mafsa::get_edges(const char* const word, int lexicon_id) const noexcept
+{
+    return mafsa_prefix_edges_in(&mafsa_, word, lexicon_id);
+}
+
+static cicero_node lexicon_root(const void* data)
+{
+    return reinterpret_cast<const Mafsa*>(data)->root();
+}
+
+static cicero_node lexicon_child(const void* data, cicero_node node, int letter)
+{
+    return reinterpret_cast<const Mafsa*>(data)->child(node, letter);
+}
+
+static_assert(MAFSA_TERM == CICERO_TERMINAL, "a packed state is its own cicero edge mask");
+
+static uint32_t lexicon_edges(const void* data, cicero_node node)
+{
+    const mafsa& m = **reinterpret_cast<const Mafsa*>(data);
+    assert(0 <= node && node < m.size);
+    return m.data[node] & (MAFSA_EDGES | MAFSA_TERM);
+}
+
+cicero_lexicon Mafsa::lexicon() const noexcept
+{
+    cicero_lexicon result;
+    result.root   = &lexicon_root;
+    result.child  = &lexicon_child;
+    result.edges  = &lexicon_edges;
+    result.data   = this;
+    return result;
+}
+
+template <int L>
+static uint32_t lexicon_edges_in(const void* data, cicero_node node)
+{
+    const auto* self = reinterpret_cast<const Mafsa*>(data);
+    return self->edges(node, L) | (self->isterm(node, L) ? CICERO_TERMINAL : 0u);
+}
+
+cicero_lexicon Mafsa::lexicon(int lexicon_id) const noexcept
+{
+    static_assert(MAFSA_MAX_LEXICONS == 4, "add lexicon cursor instantiations");
+    constexpr std::array<uint32_t (*)(const void*, cicero_node), MAFSA_MAX_LEXICONS> edges = {
+        &lexicon_edges_in<0>, &lexicon_edges_in<1>, &lexicon_edges_in<2>, &lexicon_edges_in<3>,
+    };
+    assert(0 <= lexicon_id && lexicon_id < MAFSA_MAX_LEXICONS);
+    cicero_lexicon result = lexicon();
+    result.edges  = edges[static_cast<std::size_t>(lexicon_id)];
+    return result;
+}
+
 static bool ends_with(const std::string& s, std::string_view sv)
 {
     return (
@@ -43,25 +132,25 @@ static std::vector<char> read_gz_dict_file(const std::string& filename)
         gzclose(file);
         throw std::runtime_error("unable to open input file");
     }
-    constexpr std::size_t chunk = 1024;
+    constexpr std::size_t chunk = 1u << 20;
+    gzbuffer(file, chunk);
     std::size_t len = 0;
     std::vector<char> buf(chunk, '\0');
     int rc;
-    while ((rc = gzread(file, &buf[len], chunk)) > 0) {
+    while ((rc = gzread(file, &buf[len], static_cast<unsigned int>(buf.size() - len))) > 0) {
         len += static_cast<std::size_t>(rc);
-        buf.insert(buf.end(), chunk, '\0');
+        if (buf.size() - len < chunk) {
+            buf.resize(buf.size() * 2);
+        }
     }
-    if (!gzeof(file)) {
-        // TEMP TEMP
+    if (rc < 0 || !gzeof(file)) {
         int errnum = 0;
         std::cerr << "error: unable to read GZIP file [" << rc << "]: " << gzerror(file, &errnum) << std::endl;
         gzclose(file);
         throw std::runtime_error("unable to read input file -- not GZIP format?");
     }
     gzclose(file);
-    assert(gzeof(file));
-    using diff_type = typename std::vector<char>::difference_type;
-    buf.erase(std::next(buf.cbegin(), static_cast<diff_type>(len)), buf.cend());
+    buf.resize(len);
     return buf;
 }
 
@@ -81,89 +170,277 @@ std::vector<char> read_dict_file(const std::string& filename)
     return data;
 }
 
-std::optional<Mafsa> MafsaBuilder::build_from_file(const std::string& path, int max_words)
+std::optional<Mafsa> MafsaBuilder::build_from_file(const std::string& path, int max_words,
+        MafsaType type, int threads)
 {
-    MafsaBuilder builder;
-    std::string word;
-    std::ifstream ifs{path};
-    int n_words = 0;
-    if (!ifs) {
-        std::cerr << "error: unable to open input file\n";
+    return build_from_files({ path }, max_words, type, threads);
+}
+
+std::optional<Mafsa> MafsaBuilder::build_from_files(const std::vector<std::string>& paths, int max_words,
+        MafsaType type, int threads)
+{
+    std::vector<WordList> lexicons;
+    for (const auto& path : paths) {
+        WordListSummary summary;
+        auto words = WordList::read(path, max_words, summary);
+        if (!words) {
+            return std::nullopt;
+        }
+        if (summary.skipped() > 0) {
+            summary.print(std::cerr, path);
+        }
+        lexicons.push_back(std::move(*words));
+    }
+    return build_lexicons(lexicons, type, threads);
+}
+
+std::optional<Mafsa> MafsaBuilder::build_lexicons(const std::vector<WordList>& lexicons, MafsaType type, int threads)
+{
+    if (lexicons.empty() || lexicons.size() > MAFSA_MAX_LEXICONS) {
+        std::cerr << "error: a dictionary holds 1 to " << MAFSA_MAX_LEXICONS << " lexicons\n";
         return std::nullopt;
     }
-    while (ifs >> word) {
-        if (word.empty()) {
-            continue;
-        }
-        if (word.size() < 2 || word.size() > 15) {
-            std::cerr << "warning: skipping invalid word: \"" << word << "\"\n";
+    if (threads > 1) {
+        return build_sharded(lexicons.data(), lexicons.size(), type, threads);
+    }
+    MafsaBuilder builder;
+    for (std::size_t l = 0; l < lexicons.size(); ++l) {
+        const WordList& words = lexicons[l];
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            const char* word = words[i];
+            const int rc = type == MafsaType::eGaddag
+                ? mafsa_builder_insert_gaddag_in(&builder.builder, word, 1u << l, ~0u)
+                : mafsa_builder_insert_in(&builder.builder, word, 1u << l);
+            if (rc != 0) {
+                std::cerr << "error: unable to insert word: " << word << "\n";
+                return std::nullopt;
+            }
         }
-        bool valid_word = true;
-        for (std::size_t i = 0; i < word.size(); ++i) {
-            char c = word[i];
-            if ('a' <= c && c <= 'z') {
-                word[i] = static_cast<char>((c - 'a') + 'A');
-            } else if ('A' <= c && c <= 'Z') {
-                word[i] = c;
+    }
+    return builder.finish();
+}
+
+std::optional<Mafsa> MafsaBuilder::build_sharded(const WordList& words, MafsaType type, int threads)
+{
+    return build_sharded(&words, 1, type, threads);
+}
+
+std::optional<Mafsa> MafsaBuilder::build_sharded(const WordList* lexicons, std::size_t nlexicons,
+        MafsaType type, int threads)
+{
+    // Shards hold disjoint sets of first letters (of the inserted strings, so
+    // for a GADDAG a word's paths are spread over several shards). Letters are
+    // handed out largest first to the least loaded shard, weighted by the
+    // number of letters that will be inserted.
+    constexpr int nletters = 26;
+    std::array<std::size_t, nletters> weight{};
+    for (std::size_t l = 0; l < nlexicons; ++l) {
+        const WordList& words = lexicons[l];
+        for (std::size_t i = 0; i < words.size(); ++i) {
+            const std::string_view word = words.view(i);
+            if (type == MafsaType::eGaddag) {
+                for (char c : word) {
+                    weight[static_cast<std::size_t>(c - 'A')] += word.size();
+                }
             } else {
-                std::cerr << "warning: invalid character '" << c << "' in word \"" << word << "\"\n";
-                valid_word = false;
-                break;
+                weight[static_cast<std::size_t>(word[0] - 'A')] += word.size();
             }
         }
-        if (valid_word) {
-            if (!builder.insert(word)) {
-                std::cerr << "error: unable to insert word: " << word << "\n";
-                return std::nullopt;
-            }
-            if (++n_words >= max_words) {
-                break;
+    }
+    std::array<int, nletters> letters;
+    std::iota(letters.begin(), letters.end(), 0);
+    std::stable_sort(letters.begin(), letters.end(), [&weight](int a, int b) {
+        return weight[static_cast<std::size_t>(a)] > weight[static_cast<std::size_t>(b)];
+    });
+    const auto nshards = static_cast<std::size_t>(std::clamp(threads, 1, nletters));
+    std::vector<std::size_t>  load(nshards, 0);
+    std::vector<unsigned int> firsts(nshards, 0u);
+    for (int c : letters) {
+        const auto k = static_cast<std::size_t>(std::distance(load.begin(), std::min_element(load.begin(), load.end())));
+        load[k]   += weight[static_cast<std::size_t>(c)];
+        firsts[k] |= 1u << c;
+    }
+
+    std::vector<MafsaBuilder> shards(nshards);
+    std::vector<int> failed(nshards, 0);
+    std::vector<std::thread> workers;
+    for (std::size_t k = 0; k < nshards; ++k) {
+        workers.emplace_back([&, k]() {
+            mafsa_builder* b = &shards[k].builder;
+            const unsigned int mask = firsts[k];
+            for (std::size_t l = 0; l < nlexicons; ++l) {
+                const WordList& words = lexicons[l];
+                for (std::size_t i = 0; i < words.size(); ++i) {
+                    const char* word = words[i];
+                    int rc = 0;
+                    if (type == MafsaType::eGaddag) {
+                        rc = mafsa_builder_insert_gaddag_in(b, word, 1u << l, mask);
+                    } else if ((mask & (1u << (word[0] - 'A'))) != 0) {
+                        rc = mafsa_builder_insert_in(b, word, 1u << l);
+                    }
+                    if (rc != 0) {
+                        failed[k] = 1;
+                        return;
+                    }
+                }
             }
+            failed[k] = mafsa_builder_minimize(b) != 0 ? 1 : 0;
+        });
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    if (std::find(failed.begin(), failed.end(), 1) != failed.end()) {
+        std::cerr << "error: unable to build dictionary shard\n";
+        return std::nullopt;
+    }
+
+    // the shards are minimal on their own, finish() minimizes the union to
+    // share suffixes between them. This runs on the calling thread only and
+    // is about a fifth of a one thread build of CSW19 (DAWG or GADDAG), so
+    // that is as far as more threads can take it.
+    MafsaBuilder result;
+    for (auto& shard : shards) {
+        if (mafsa_builder_merge(&result.builder, &shard.builder, 1) != 0) {
+            std::cerr << "error: unable to merge dictionary shards\n";
+            return std::nullopt;
         }
     }
-    return builder.finish();
+    return result.finish();
 }
 
-std::optional<Mafsa> Mafsa::load(const std::string& filename)
+std::optional<Mafsa> Mafsa::load(const std::string& filename, MafsaType type)
 {
     if (ends_with(filename, ".txt")) {
-        return MafsaBuilder::build_from_file(filename);
+        const auto threads = static_cast<int>(std::thread::hardware_concurrency());
+        return MafsaBuilder::build_from_file(filename, INT_MAX, type, threads);
+    }
+    if (!ends_with(filename, ".gz")) {
+        const int fd = open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "error: unable to open dictionary file: " << filename << "\n";
+            return std::nullopt;
+        }
+        struct stat st;
+        char magic[sizeof(kNativeMagic)];
+        if (fstat(fd, &st) == 0 &&
+            pread(fd, magic, sizeof(magic), 0) == static_cast<ssize_t>(sizeof(magic)) &&
+            memcmp(magic, kNativeMagic, sizeof(magic)) == 0) {
+            auto result = load_native(fd, static_cast<std::size_t>(st.st_size), type);
+            close(fd);
+            return result;
+        }
+        close(fd);
+    }
+    return load_flatbuffers(filename);
+}
+
+std::optional<Mafsa> Mafsa::load_native(int fd, std::size_t length, MafsaType type)
+{
+    NativeHeader header;
+    if (pread(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        std::cerr << "error: truncated dictionary file\n";
+        return std::nullopt;
+    }
+    if (header.byte_order != kByteOrderMark) {
+        std::cerr << "error: dictionary file was written with a different byte order\n";
+        return std::nullopt;
     }
+    if (header.version != kNativeVersion) {
+        std::cerr << "error: unsupported dictionary file version: " << header.version << "\n";
+        return std::nullopt;
+    }
+    if (header.type != native_type(type)) {
+        std::cerr << "error: dictionary file is a " << (header.type == 1 ? "GADDAG" : "DAWG") << "\n";
+        return std::nullopt;
+    }
+    if (header.count == 0 || header.count > INT_MAX ||
+        length != sizeof(header) + header.count * sizeof(uint32_t)) {
+        std::cerr << "error: truncated or corrupt dictionary file\n";
+        return std::nullopt;
+    }
+    void* mapping = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        std::cerr << "error: unable to map dictionary file\n";
+        return std::nullopt;
+    }
+    Mafsa result;
+    // the C API never writes through `data`
+    result.mafsa_.data    = reinterpret_cast<unsigned int*>(static_cast<char*>(mapping) + sizeof(header));
+    result.mafsa_.size    = static_cast<int>(header.count);
+    result.mafsa_.nstates = static_cast<int>(header.nstates);
+    result.mapping_       = mapping;
+    result.mapping_size_  = length;
+    return result;
+}
+
+bool Mafsa::save(const std::string& filename, MafsaType type) const
+{
+    NativeHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, kNativeMagic, sizeof(header.magic));
+    header.version    = kNativeVersion;
+    header.byte_order = kByteOrderMark;
+    header.type       = native_type(type);
+    header.nstates    = static_cast<uint32_t>(mafsa_.nstates);
+    header.count      = static_cast<uint64_t>(mafsa_.size);
 
+    return write_replacing(filename, {
+        { &header, sizeof(header) },
+        { mafsa_.data, sizeof(mafsa_.data[0]) * static_cast<std::size_t>(mafsa_.size) },
+    });
+}
+
+std::optional<Mafsa> Mafsa::load_flatbuffers(const std::string& filename)
+{
     auto buf = read_dict_file(filename);
     auto serial_mafsa = GetSerialMafsa(buf.data());
     flatbuffers::Verifier v(reinterpret_cast<const uint8_t*>(buf.data()), buf.size());
     assert(serial_mafsa->Verify(v));
 
-    // using uint = unsigned int;
-    using Node = mafsa_node_;
     if (!serial_mafsa->nodes()) {
         return std::nullopt;
     }
-    size_t size = serial_mafsa->nodes()->size();
-    Node* nodes = reinterpret_cast<Node*>(malloc(size * sizeof(*nodes)));
-    uint* terms = reinterpret_cast<uint*>(malloc(size * sizeof(*terms)));
-    // auto nodes = std::make_unique<Node[]>(size);
-    // auto terms = std::make_unique<uint[]>(size);
-    memset(&nodes[0], 0, sizeof(nodes[0]) * size);
-    memset(&terms[0], 0, sizeof(terms[0]) * size);
-    size_t index = 0;
-    for (const auto* node : *serial_mafsa->nodes()) {
-        if (node->term()) {
-            const auto entry = index / sizeof(terms[0]);
-            const auto shift = index % sizeof(terms[0]);
-            terms[entry] |= 1u << shift;
-        }
-        for (const auto* link : *node->children()) {
-            nodes[index].children[link->value()] = link->next();
+    // serialized states are numbered densely, packed states are offsets
+    const auto* serial_nodes = serial_mafsa->nodes();
+    const size_t nstates = serial_nodes->size();
+    std::vector<unsigned int> offsets(nstates);
+    size_t length = 0;
+    size_t index  = 0;
+    for (const auto* node : *serial_nodes) {
+        offsets[index++] = static_cast<unsigned int>(length);
+        length += 1 + (node->children() ? node->children()->size() : 0);
+    }
+    auto* data = reinterpret_cast<unsigned int*>(malloc(length * sizeof(unsigned int)));
+    if (!data) {
+        return std::nullopt;
+    }
+    index = 0;
+    for (const auto* node : *serial_nodes) {
+        const size_t i = index++;
+        // flatbuffers files hold a single lexicon, and every state leads to a word
+        unsigned int edges = node->term() ? MAFSA_TERM | (1u << MAFSA_LEXSHIFT) : 0u;
+        if (node->children()) {
+            for (const auto* link : *node->children()) {
+                if (!(0 <= link->value() && link->value() < MAFSA_NEDGES) ||
+                    !(0 <= link->next() && static_cast<size_t>(link->next()) < nstates)) {
+                    free(data);
+                    return std::nullopt;
+                }
+                edges |= 1u << link->value();
+            }
+            // links are written in edge order, but don't depend on it
+            for (const auto* link : *node->children()) {
+                const unsigned int below = edges & ((1u << link->value()) - 1u);
+                const auto rank = static_cast<size_t>(__builtin_popcount(below & MAFSA_EDGES));
+                data[offsets[i] + 1 + rank] = offsets[static_cast<size_t>(link->next())] | (1u << MAFSA_LEXSHIFT);
+            }
         }
-        ++index;
+        data[offsets[i]] = edges;
     }
     Mafsa result;
-    // result.mafsa_.nodes = nodes.release();
-    // result.mafsa_.terms = terms.release();
-    result.mafsa_.nodes = nodes;
-    result.mafsa_.terms = terms;
-    result.mafsa_.size  = static_cast<int>(size);
+    result.mafsa_.data    = data;
+    result.mafsa_.size    = static_cast<int>(length);
+    result.mafsa_.nstates = static_cast<int>(nstates);
     return result;
 }
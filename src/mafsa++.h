@@ -2,19 +2,34 @@
 
 #include <optional>
 #include <mafsa/mafsa.h>
+#include <cicero/cicero.h>
 #include <memory>
 #include <climits>
+#include <string>
+#include <vector>
 #include "mafsa_generated.h"
+#include "wordlist.h"
 
 
+enum class MafsaType
+{
+    eDawg,
+    eGaddag,
+};
+
 struct Mafsa
 {
     explicit Mafsa(mafsa&& m) noexcept : mafsa_{m} {}
-    Mafsa(Mafsa&& other) noexcept : mafsa_{other.mafsa_}
+    Mafsa(Mafsa&& other) noexcept
+        : mafsa_{other.mafsa_}
+        , mapping_{other.mapping_}
+        , mapping_size_{other.mapping_size_}
     {
-        other.mafsa_.nodes = nullptr;
-        other.mafsa_.terms = nullptr;
-        other.mafsa_.size  = 0;
+        other.mafsa_.data    = nullptr;
+        other.mafsa_.size    = 0;
+        other.mafsa_.nstates = 0;
+        other.mapping_       = nullptr;
+        other.mapping_size_  = 0;
     }
     ~Mafsa() noexcept;
     const mafsa& operator*() const  { return mafsa_; }
@@ -23,11 +38,35 @@ struct Mafsa
     bool isterm(int s) const noexcept;
     mafsa_edges get_edges(const char* const word) const noexcept;
     mafsa_edges get_edges(const std::string& word) const noexcept { return get_edges(word.c_str()); }
-    static std::optional<Mafsa> load(const std::string& filename);
+    int root() const noexcept { return mafsa_root(&mafsa_); }
+    int child(int s, int c) const noexcept { return mafsa_child(&mafsa_, s, c); }
+    unsigned int edges(int s) const noexcept { return mafsa_edgemask(&mafsa_, s); }
+    // cursor over this dictionary for cicero's move generator; only valid
+    // as long as this object isn't moved or destroyed
+    cicero_lexicon lexicon() const noexcept;
+
+    // the same queries restricted to one lexicon of a dictionary built with
+    // MafsaBuilder::build_lexicons(), 0 <= `lexicon_id` < MAFSA_MAX_LEXICONS
+    bool isword(const std::string& word, int lexicon_id) const noexcept;
+    bool isterm(int s, int lexicon_id) const noexcept;
+    mafsa_edges get_edges(const char* const word, int lexicon_id) const noexcept;
+    mafsa_edges get_edges(const std::string& word, int lexicon_id) const noexcept { return get_edges(word.c_str(), lexicon_id); }
+    unsigned int edges(int s, int lexicon_id) const noexcept { return mafsa_edgemask_in(&mafsa_, s, lexicon_id); }
+    cicero_lexicon lexicon(int lexicon_id) const noexcept;
+    // `type` is used when building from a word list (.txt), and checked
+    // against the file's type for the native format. Native files are
+    // mmap'd read-only and used in place.
+    static std::optional<Mafsa> load(const std::string& filename, MafsaType type=MafsaType::eDawg);
+    // writes the native format
+    bool save(const std::string& filename, MafsaType type=MafsaType::eDawg) const;
 
 private:
     Mafsa() : mafsa_{} {}
-    mafsa mafsa_;
+    static std::optional<Mafsa> load_native(int fd, std::size_t length, MafsaType type);
+    static std::optional<Mafsa> load_flatbuffers(const std::string& filename);
+    mafsa       mafsa_;
+    void*       mapping_      = nullptr; // non-null if `mafsa_.data` points into a mapped file
+    std::size_t mapping_size_ = 0;
 };
 
 
@@ -53,6 +92,22 @@ struct MafsaBuilder
         return mafsa_builder_insert(&builder, word.c_str()) == 0;
     }
 
+    bool insert_gaddag(const std::string word)
+    {
+        return mafsa_builder_insert_gaddag(&builder, word.c_str()) == 0;
+    }
+
+    // `lexicons` is a mask, bit `l` for lexicon `l`
+    bool insert_in(const std::string word, unsigned int lexicons)
+    {
+        return mafsa_builder_insert_in(&builder, word.c_str(), lexicons) == 0;
+    }
+
+    bool insert_gaddag_in(const std::string word, unsigned int lexicons)
+    {
+        return mafsa_builder_insert_gaddag_in(&builder, word.c_str(), lexicons, ~0u) == 0;
+    }
+
     // TODO: return Mafsa instead
     std::optional<Mafsa> finish()
     {
@@ -63,7 +118,23 @@ struct MafsaBuilder
         return Mafsa{std::move(out)};
     }
 
-    static std::optional<Mafsa> build_from_file(const std::string& filename, int max_words=INT_MAX);
+    // `threads` > 1 builds with build_sharded()
+    static std::optional<Mafsa> build_from_file(const std::string& filename, int max_words=INT_MAX,
+            MafsaType type=MafsaType::eDawg, int threads=1);
+
+    // builds one dictionary holding several lexicons, the words of `paths[l]`
+    // (or `lexicons[l]`) make up lexicon `l`
+    static std::optional<Mafsa> build_from_files(const std::vector<std::string>& paths, int max_words=INT_MAX,
+            MafsaType type=MafsaType::eDawg, int threads=1);
+    static std::optional<Mafsa> build_lexicons(const std::vector<WordList>& lexicons, MafsaType type, int threads=1);
+
+    // builds shards of the dictionary in parallel (split by first letter),
+    // then merges and minimizes them on the calling thread
+    static std::optional<Mafsa> build_sharded(const WordList& words, MafsaType type, int threads);
 
     mafsa_builder builder;
+
+private:
+    static std::optional<Mafsa> build_sharded(const WordList* lexicons, std::size_t nlexicons,
+            MafsaType type, int threads);
 };
@@ -5,46 +5,29 @@
 #include <climits>
 #include <cassert>
 #include <vector>
+#include <algorithm>
+#include <cstring>
+#include <thread>
 #include <mafsa++.h>
 
 
-bool test_dictionary(const Mafsa& dict, std::string path, int max_words)
+bool test_dictionary(const Mafsa& dict, std::string path, int max_words, MafsaType type, int lexicon)
 {
-    std::string word;
-    std::ifstream ifs{path};
-    int n_words = 0;
-    if (!ifs) {
-        std::cerr << "error: unable to open input file\n";
+    WordListSummary summary;
+    auto words = WordList::read(path, max_words, summary);
+    if (!words) {
         return false;
     }
-    while (ifs >> word) {
-        if (word.empty()) {
-            continue;
-        }
-        if (word.size() < 2 || word.size() > 15) {
-            std::cerr << "warning: skipping invalid word: \"" << word << "\"\n";
+    std::string word;
+    for (std::size_t i = 0; i < words->size(); ++i) {
+        word.assign(words->view(i));
+        if (type == MafsaType::eGaddag) {
+            // the GADDAG path that doesn't cross the separator is the reversed word
+            std::reverse(word.begin(), word.end());
         }
-        bool valid_word = true;
-        for (std::size_t i = 0; i < word.size(); ++i) {
-            char c = word[i];
-            if ('a' <= c && c <= 'z') {
-                word[i] = static_cast<char>((c - 'a') + 'A');
-            } else if ('A' <= c && c <= 'Z') {
-                word[i] = c;
-            } else {
-                std::cerr << "warning: invalid character '" << c << "' in word \"" << word << "\"\n";
-                valid_word = false;
-                break;
-            }
-        }
-        if (valid_word) {
-            if (!dict.isword(word)) {
-                std::cerr << "Failed on word: " << word << "\n";
-                return false;
-            }
-            if (++n_words >= max_words) {
-                break;
-            }
+        if (!dict.isword(word, lexicon)) {
+            std::cerr << "Failed on word: " << word << "\n";
+            return false;
         }
     }
     return true;
@@ -72,23 +55,25 @@ void write_data(const std::string& filename, const uint8_t* buf, std::size_t len
 
 void write_mafsa(const Mafsa& mm, const std::string& filename)
 {
-    auto make_serial_links = [](const int* children)
-    {
-        std::vector<SerialMafsaLink> result;
-        for (int value = 0; value < 26; ++value) {
-            if (children[value] != 0) {
-                result.emplace_back(value, children[value]);
-            }
-        }
-        return result;
-    };
+    // packed states are offsets into `data`, serialized states are numbered
+    // in the same order
+    std::vector<int> states;
+    std::vector<int> index(static_cast<std::size_t>(mm->size), -1);
+    for (int s = 0; s < mm->size; s += 1 + __builtin_popcount(mm.edges(s))) {
+        index[static_cast<std::size_t>(s)] = static_cast<int>(states.size());
+        states.push_back(s);
+    }
 
     flatbuffers::FlatBufferBuilder builder;
     std::vector<flatbuffers::Offset<SerialMafsaNode>> nodes;
-    for (int i = 0; i < mm->size; ++i) {
-        const auto* node = &mm->nodes[i];
-        auto children = make_serial_links(node->children);
-        auto serial_node = CreateSerialMafsaNodeDirect(builder, mm.isterm(i), &children);
+    for (int s : states) {
+        std::vector<SerialMafsaLink> children;
+        for (int value = 0; value < MAFSA_NEDGES; ++value) {
+            if ((mm.edges(s) & (1u << value)) != 0) {
+                children.emplace_back(value, index[static_cast<std::size_t>(mm.child(s, value))]);
+            }
+        }
+        auto serial_node = CreateSerialMafsaNodeDirect(builder, mm.isterm(s), &children);
         nodes.emplace_back(serial_node);
     }
     auto serial_mafsa = CreateSerialMafsaDirect(builder, &nodes);
@@ -102,36 +87,77 @@ int main(int argc, char** argv)
 {
     // TODO: real command line parser
     if (argc == 0) {
-        std::cerr << "Usage: " << argv[0] << " [FILE]" << std::endl;
+        std::cerr << "Usage: " << argv[0] << " [--gaddag] [--flatbuffers] [--threads=N] [--lexicon=FILE]... [FILE] [MAX WORDS] [OUTPUT]" << std::endl;
         return 0;
     }
 
-    const std::string inname    = argc >= 2 ? argv[1]       : "";
+    MafsaType type = MafsaType::eDawg;
+    bool flatbuffers = false;
+    int threads = static_cast<int>(std::thread::hardware_concurrency());
+    // FILE is lexicon 0, each --lexicon adds the next one
+    std::vector<std::string> innames(1);
+    while (argc >= 2 && std::string{argv[1]}.rfind("--", 0) == 0) {
+        const std::string flag = argv[1];
+        if (flag == "--gaddag") {
+            type = MafsaType::eGaddag;
+        } else if (flag == "--flatbuffers") {
+            flatbuffers = true;
+        } else if (flag.rfind("--threads=", 0) == 0) {
+            threads = atoi(flag.c_str() + strlen("--threads="));
+        } else if (flag.rfind("--lexicon=", 0) == 0) {
+            innames.push_back(flag.substr(strlen("--lexicon=")));
+        } else {
+            std::cerr << "error: unknown option: " << flag << std::endl;
+            return 1;
+        }
+        --argc;
+        ++argv;
+    }
+
+    const std::string ext       = type == MafsaType::eGaddag ? ".gaddag" : ".dict";
+    innames[0] = argc >= 2 ? argv[1] : "";
+    const std::string inname    = innames[0];
     const int         max_words = argc >= 3 ? atoi(argv[2]) : INT_MAX;
-    const std::string outname   = argc >= 4 ? argv[3]       : make_out_filename(inname, ".dict");
+    const std::string outname   = argc >= 4 ? argv[3]       : make_out_filename(inname, ext);
 
-    std::cout << "INPUT:     " << inname    << "\n"
-              << "OUTPUT   : " << outname   << "\n"
+    for (std::size_t l = 0; l < innames.size(); ++l) {
+        std::cout << "INPUT " << l << ":   " << innames[l] << "\n";
+    }
+    std::cout << "OUTPUT   : " << outname   << "\n"
               << "MAX WORDS: " << max_words << "\n"
+              << "TYPE:      " << (type == MafsaType::eGaddag ? "GADDAG" : "DAWG") << "\n"
+              << "FORMAT:    " << (flatbuffers ? "flatbuffers" : "native") << "\n"
+              << "THREADS:   " << threads << "\n"
               ;
 
     if (inname.empty() || max_words <= 0) {
         std::cerr << "error: invalid arguments";
         return 1;
     }
+    if (flatbuffers && innames.size() > 1) {
+        std::cerr << "error: the flatbuffers format holds a single lexicon" << std::endl;
+        return 1;
+    }
 
-    auto maybe_dict = MafsaBuilder::build_from_file(inname, max_words);
+    auto maybe_dict = MafsaBuilder::build_from_files(innames, max_words, type, threads);
     if (!maybe_dict) {
         return 1;
     }
     const auto& dict = *maybe_dict;
 
-    if (!test_dictionary(dict, inname, max_words)) {
-        std::cerr << "dictionary test failed!" << std::endl;
-        return 1;
+    for (std::size_t l = 0; l < innames.size(); ++l) {
+        if (!test_dictionary(dict, innames[l], max_words, type, static_cast<int>(l))) {
+            std::cerr << "dictionary test failed!" << std::endl;
+            return 1;
+        }
     }
 
-    write_mafsa(dict, outname);
+    if (flatbuffers) {
+        write_mafsa(dict, outname);
+    } else if (!dict.save(outname, type)) {
+        std::cerr << "error: unable to write output file: " << outname << std::endl;
+        return 1;
+    }
 
     return 0;
 }
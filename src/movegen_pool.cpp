@@ -0,0 +1,117 @@
+#include "movegen_pool.h"
+#include <algorithm>
+#include <cstring>
+
+MoveGenPool::MoveGenPool(int threads)
+    : buffers_(static_cast<std::size_t>(std::max(threads, 1)))
+{
+    for (auto& buffer : buffers_) {
+        buffer.moves.resize(kInitialMoves);
+    }
+    for (std::size_t k = 1; k < buffers_.size(); ++k) {
+        workers_.emplace_back([this, k]() { work(k); });
+    }
+}
+
+MoveGenPool::~MoveGenPool()
+{
+    {
+        std::lock_guard<std::mutex> guard{lock_};
+        stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& worker : workers_) {
+        worker.join();
+    }
+}
+
+const std::vector<cicero_move_record>& MoveGenPool::generate(const cicero* e, cicero_rack rack)
+{
+    e_      = e;
+    rack_   = rack;
+    nitems_ = cicero_move_items(e, items_);
+    // a single thread might as well take everything in one go
+    nbatches_ = std::min(nitems_, workers_.empty() ? 1 : kBatchesPerThread * threads());
+    next_.store(0, std::memory_order_relaxed);
+    for (auto& buffer : buffers_) {
+        buffer.used = 0;
+    }
+    if (!workers_.empty()) {
+        {
+            std::lock_guard<std::mutex> guard{lock_};
+            busy_ = static_cast<int>(workers_.size());
+            ++round_;
+        }
+        start_.notify_all();
+    }
+    run(0);
+    if (!workers_.empty()) {
+        std::unique_lock<std::mutex> guard{lock_};
+        done_.wait(guard, [this]() { return busy_ == 0; });
+    }
+
+    std::size_t total = 0;
+    for (int b = 0; b < nbatches_; ++b) {
+        total += spans_[b].count;
+    }
+    result_.resize(total);
+    auto* out = result_.data();
+    for (int b = 0; b < nbatches_; ++b) {
+        const Span& span = spans_[b];
+        if (span.count == 0) {
+            continue;
+        }
+        std::memcpy(out, buffers_[span.buffer].moves.data() + span.offset, span.count * sizeof(*out));
+        out += span.count;
+    }
+    return result_;
+}
+
+void MoveGenPool::work(std::size_t buffer)
+{
+    unsigned long seen = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> guard{lock_};
+            start_.wait(guard, [&]() { return stop_ || round_ != seen; });
+            if (stop_) {
+                return;
+            }
+            seen = round_;
+        }
+        run(buffer);
+        bool last;
+        {
+            std::lock_guard<std::mutex> guard{lock_};
+            last = --busy_ == 0;
+        }
+        if (last) {
+            done_.notify_one();
+        }
+    }
+}
+
+void MoveGenPool::run(std::size_t buffer)
+{
+    Buffer& buf = buffers_[buffer];
+    for (int b; (b = next_.fetch_add(1, std::memory_order_relaxed)) < nbatches_; ) {
+        // batch `b` is items [first, last)
+        const int first = static_cast<int>(static_cast<long>(nitems_) * b / nbatches_);
+        const int last  = static_cast<int>(static_cast<long>(nitems_) * (b + 1) / nbatches_);
+        cicero_move_sink sink;
+        sink.skip = 0;
+        for (;;) {
+            sink.moves = buf.moves.data() + buf.used;
+            sink.cap   = static_cast<int>(buf.moves.size() - buf.used);
+            cicero_generate_items_into(e_, rack_, &items_[first], last - first, &sink);
+            if (sink.total <= sink.cap) {
+                break;
+            }
+            // the moves come out the same every time, so just make room and go again
+            const auto need = buf.used + static_cast<std::size_t>(sink.total);
+            buf.moves.resize(std::max(need, 2 * buf.moves.size()));
+        }
+        spans_[b] = Span{buffer, buf.used, static_cast<std::size_t>(sink.total)};
+        buf.used += static_cast<std::size_t>(sink.total);
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <cicero/cicero.h>
+
+// Generates the legal moves of a position on a pool of threads. The anchors
+// and directions (see cicero_move_items) are split into consecutive batches
+// that are handed out to whichever thread is free, each thread writes its
+// moves to its own buffer and the buffers are stitched back together in batch
+// order, so the moves are the same as cicero_generate_legal_moves_into's
+// whatever the # of threads.
+class MoveGenPool
+{
+public:
+    // `threads` counts the calling thread, which generates moves too
+    explicit MoveGenPool(int threads);
+    ~MoveGenPool();
+    MoveGenPool(const MoveGenPool&) = delete;
+    MoveGenPool& operator=(const MoveGenPool&) = delete;
+
+    // All the legal moves of `rack`, valid until the next call. Not to be
+    // called from several threads at once.
+    const std::vector<cicero_move_record>& generate(const cicero* e, cicero_rack rack);
+
+    int threads() const noexcept { return static_cast<int>(buffers_.size()); }
+
+private:
+    // batches per thread, enough to even out lanes of very different cost
+    // without paying cicero_generate_items_into's setup for every item
+    static constexpr int kBatchesPerThread = 4;
+    // moves each buffer starts with, so that the first call doesn't have to
+    // generate anything twice to find out how much room it needs
+    static constexpr std::size_t kInitialMoves = 1 << 14;
+
+    // where a batch's moves are
+    struct Span
+    {
+        std::size_t buffer;
+        std::size_t offset;
+        std::size_t count;
+    };
+
+    struct Buffer
+    {
+        std::vector<cicero_move_record> moves; // grown as needed, kept between calls
+        std::size_t                     used = 0;
+    };
+
+    void work(std::size_t buffer);
+    // generates batches until there are none left
+    void run(std::size_t buffer);
+
+    std::vector<Buffer>             buffers_; // by thread, 0 is the calling thread's
+    std::vector<std::thread>        workers_;
+    std::vector<cicero_move_record> result_;
+
+    // the current call's work, read by the workers once `round_` changes
+    const cicero*    e_ = nullptr;
+    cicero_rack      rack_{};
+    int              items_[2 * 225];
+    Span             spans_[2 * 225]; // by batch
+    int              nitems_ = 0;
+    int              nbatches_ = 0;
+    std::atomic<int> next_{0};
+
+    std::mutex              lock_;
+    std::condition_variable start_;
+    std::condition_variable done_;
+    unsigned long           round_ = 0;
+    int                     busy_  = 0;
+    bool                    stop_  = false;
+};
@@ -0,0 +1,45 @@
+#include "native_file.h"
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+
+bool write_replacing(const std::string& filename, std::initializer_list<std::pair<const void*, std::size_t>> chunks)
+{
+    // the pid tells processes apart and the counter saves in this one; the
+    // file is created like any other, so it gets the mode the umask allows
+    static std::atomic<unsigned long> next{0};
+    std::string tmpname;
+    int fd = -1;
+    for (int tries = 0; fd < 0 && tries < 100; ++tries) {
+        tmpname = filename + "." + std::to_string(getpid()) + "." + std::to_string(next++) + ".tmp";
+        fd = open(tmpname.c_str(), O_CREAT | O_EXCL | O_WRONLY | O_CLOEXEC, 0666);
+        if (fd < 0 && errno != EEXIST) {
+            return false;
+        }
+    }
+    if (fd < 0) {
+        return false;
+    }
+    bool ok = true;
+    for (const auto& [data, size] : chunks) {
+        const char* p    = static_cast<const char*>(data);
+        std::size_t left = size;
+        while (ok && left > 0) {
+            const ssize_t n = write(fd, p, left);
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            ok    = n > 0;
+            p    += n > 0 ? n : 0;
+            left -= n > 0 ? static_cast<std::size_t>(n) : 0;
+        }
+    }
+    ok = close(fd) == 0 && ok;
+    if (!ok || std::rename(tmpname.c_str(), filename.c_str()) != 0) {
+        std::remove(tmpname.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <string>
+#include <utility>
+#include "mafsa++.h"
+
+// Pieces shared by the native file formats of Mafsa and DATrie: a fixed
+// header followed by the format's arrays exactly as they are laid out in
+// memory, so a file can be mapped and used without any per-state work. The
+// header is 32 bytes which keeps the arrays after it aligned.
+
+constexpr uint32_t kByteOrderMark = 0x01020304u;
+
+struct NativeHeader
+{
+    char     magic[8];   // the format's
+    uint32_t version;    // ... and its version
+    uint32_t byte_order; // kByteOrderMark as written by the host
+    uint32_t type;       // 0 = DAWG, 1 = GADDAG
+    uint32_t nstates;
+    uint64_t count;      // Mafsa: # of entries in `data`, DATrie: # of slots
+};
+static_assert(sizeof(NativeHeader) == 32, "native header layout changed");
+
+inline uint32_t native_type(MafsaType type) noexcept
+{
+    return type == MafsaType::eGaddag ? 1u : 0u;
+}
+
+// Writes `chunks` to a uniquely named temporary next to `filename` and
+// renames it into place, so concurrent saves to the same path never share a
+// temporary and processes that have the old file mapped keep seeing a
+// consistent file.
+bool write_replacing(const std::string& filename, std::initializer_list<std::pair<const void*, std::size_t>> chunks);
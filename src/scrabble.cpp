@@ -253,6 +253,16 @@ std::optional<BoardAndRack> read_board(std::istream& ifs)
     return std::nullopt;
 }
 
+Rack unpack_rack(const cicero_packed_rack& rack)
+{
+    Rack result;
+    for (char tile = CICERO_TILE_A; tile <= CICERO_TILE_Z; ++tile) {
+        result.append(static_cast<std::size_t>(rack_count(rack, tile)), tile);
+    }
+    result.append(static_cast<std::size_t>(rack_count(rack, CICERO_TILE_BLANK)), CICERO_TILE_BLANK);
+    return result;
+}
+
 } // namespace scrabble
 
 std::ostream& operator<<(std::ostream& os, const cicero_rack& rack)
@@ -2,6 +2,8 @@
 
 #include <cassert>
 #include <array>
+#include <cstdint>
+#include <string>
 #include <stdexcept>
 #include <utility>
 #include <cstring>
@@ -139,6 +141,39 @@ namespace scrabble {
 
 using Rack = std::string;
 
+// Same as cicero_make_rack followed by cicero_pack_rack, so that racks known
+// up front can be packed at compile time. Unknown tiles are skipped, and so
+// are copies of a tile past the 15 that its count holds.
+constexpr cicero_packed_rack pack_rack(std::string_view tiles) noexcept
+{
+    cicero_packed_rack result{};
+    for (const char tile : tiles) {
+        const int index = tile == CICERO_TILE_BLANK ? 26
+                        : CICERO_TILE_A <= tile && tile <= CICERO_TILE_Z ? tile - CICERO_TILE_A
+                        : -1;
+        if (index < 0) {
+            continue;
+        }
+        const int shift = 4 * (index % 16);
+        if (((result.counts[index / 16] >> shift) & 15u) == 15u) {
+            continue; // would carry into the next tile's count
+        }
+        result.counts[index / 16] += std::uint64_t{1} << shift;
+        result.mask |= 1u << index;
+    }
+    return result;
+}
+
+// # of `tile` (A-Z or CICERO_TILE_BLANK) in `rack`
+constexpr int rack_count(const cicero_packed_rack& rack, char tile) noexcept
+{
+    const int index = tile == CICERO_TILE_BLANK ? 26 : tile - CICERO_TILE_A;
+    return static_cast<int>((rack.counts[index / 16] >> (4 * (index % 16))) & 15u);
+}
+
+// the tiles of `rack`, A-Z then blanks
+Rack unpack_rack(const cicero_packed_rack& rack);
+
 enum class Direction
 {
     Horz = CICERO_HORZ,
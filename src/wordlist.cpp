@@ -0,0 +1,215 @@
+#include "wordlist.h"
+#include <cstring>
+#include <iostream>
+#include <zlib.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+constexpr std::size_t kBlockSize   = 1u << 20;
+constexpr std::size_t kMaxExamples = 5;
+
+bool ends_with(const std::string& s, std::string_view sv)
+{
+    return (
+        s.size() >= sv.size() &&
+        s.compare(s.size() - sv.size(), std::string::npos, sv) == 0
+    );
+}
+
+// branch-free so that it gets vectorized
+void upcase(unsigned char* out, const unsigned char* in, std::size_t n) noexcept
+{
+    for (std::size_t i = 0; i < n; ++i) {
+        const unsigned char c = in[i];
+        const unsigned char lower = static_cast<unsigned char>(c - 'a') < 26u ? 0x20u : 0u;
+        out[i] = static_cast<unsigned char>(c - lower);
+    }
+}
+
+bool isblank_(char c) noexcept
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+}
+
+} // ~namespace
+
+// Appends input blocks to `out.chars_` upper cased, then splits off complete
+// lines in place: the newline becomes the word's NUL terminator. Skipped
+// lines are left in the buffer, they're just not indexed.
+struct WordListReader
+{
+    WordList&        out;
+    WordListSummary& summary;
+    std::size_t      max_words;
+    std::size_t      scan     = 0; // start of the first line not split off yet
+    std::size_t      lineno   = 0;
+    bool             done     = false;
+    bool             overflow = false; // offsets are 32-bit
+
+    // returns false once no more input is wanted
+    bool feed(const char* data, std::size_t n)
+    {
+        auto& chars = out.chars_;
+        const std::size_t base = chars.size();
+        if (n >= UINT32_MAX - base) {
+            overflow = done = true;
+            return false;
+        }
+        chars.resize(base + n);
+        upcase(reinterpret_cast<unsigned char*>(&chars[base]), reinterpret_cast<const unsigned char*>(data), n);
+        while (!done) {
+            char* const buf = chars.data();
+            char* const nl  = static_cast<char*>(memchr(buf + scan, '\n', chars.size() - scan));
+            if (!nl) {
+                break;
+            }
+            const auto eol = static_cast<std::size_t>(nl - buf);
+            line(scan, eol);
+            scan = eol + 1;
+        }
+        return !done;
+    }
+
+    // the last line may not end with a newline
+    void finish()
+    {
+        auto& chars = out.chars_;
+        if (!done && scan < chars.size()) {
+            chars.push_back('\n');
+            line(scan, chars.size() - 1);
+        }
+        scan = chars.size();
+    }
+
+    void line(std::size_t b, std::size_t e)
+    {
+        char* const buf = out.chars_.data();
+        ++lineno;
+        while (b < e && isblank_(buf[b])) {
+            ++b;
+        }
+        while (e > b && isblank_(buf[e - 1])) {
+            --e;
+        }
+        buf[e] = '\0';
+        if (b == e) {
+            return;
+        }
+        ++summary.lines;
+        const std::size_t len = e - b;
+        if (len < 2 || len > 15) {
+            skip(summary.bad_length, b, e);
+            return;
+        }
+        unsigned int bad = 0;
+        for (std::size_t i = b; i < e; ++i) {
+            bad |= static_cast<unsigned char>(buf[i] - 'A') >= 26u ? 1u : 0u;
+        }
+        if (bad != 0) {
+            skip(summary.bad_letters, b, e);
+            return;
+        }
+        out.offsets_.push_back(static_cast<std::uint32_t>(b));
+        out.lengths_.push_back(static_cast<std::uint8_t>(len));
+        done = out.offsets_.size() >= max_words;
+    }
+
+    void skip(std::size_t& counter, std::size_t b, std::size_t e)
+    {
+        ++counter;
+        if (summary.examples.size() < kMaxExamples) {
+            summary.examples.emplace_back(lineno, std::string(&out.chars_[b], e - b));
+        }
+    }
+};
+
+WordList::WordList(const std::vector<std::string>& words)
+{
+    for (const auto& word : words) {
+        offsets_.push_back(static_cast<std::uint32_t>(chars_.size()));
+        lengths_.push_back(static_cast<std::uint8_t>(word.size()));
+        chars_.insert(chars_.end(), word.begin(), word.end());
+        chars_.push_back('\0');
+    }
+}
+
+std::optional<WordList> WordList::read(const std::string& path, int max_words, WordListSummary& summary)
+{
+    summary = WordListSummary{};
+    WordList result;
+    if (max_words <= 0) {
+        return result;
+    }
+    WordListReader reader{result, summary, static_cast<std::size_t>(max_words)};
+
+    if (ends_with(path, ".gz")) {
+        gzFile file = gzopen(path.c_str(), "rb");
+        if (!file) {
+            std::cerr << "error: unable to open input file: " << path << "\n";
+            return std::nullopt;
+        }
+        gzbuffer(file, kBlockSize);
+        std::vector<char> block(kBlockSize);
+        int rc;
+        while ((rc = gzread(file, block.data(), static_cast<unsigned int>(block.size()))) > 0) {
+            if (!reader.feed(block.data(), static_cast<std::size_t>(rc))) {
+                break;
+            }
+        }
+        if (rc < 0) {
+            int errnum = 0;
+            std::cerr << "error: unable to read GZIP file: " << gzerror(file, &errnum) << "\n";
+            gzclose(file);
+            return std::nullopt;
+        }
+        gzclose(file);
+    } else {
+        const int fd = open(path.c_str(), O_RDONLY);
+        struct stat st;
+        if (fd < 0 || fstat(fd, &st) != 0) {
+            std::cerr << "error: unable to open input file: " << path << "\n";
+            if (fd >= 0) {
+                close(fd);
+            }
+            return std::nullopt;
+        }
+        const auto length = static_cast<std::size_t>(st.st_size);
+        if (length > 0 && length < UINT32_MAX) {
+            void* data = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data == MAP_FAILED) {
+                std::cerr << "error: unable to map input file: " << path << "\n";
+                close(fd);
+                return std::nullopt;
+            }
+            madvise(data, length, MADV_SEQUENTIAL);
+            result.chars_.reserve(length + 1);
+            reader.feed(static_cast<const char*>(data), length);
+            munmap(data, length);
+        } else if (length > 0) {
+            reader.overflow = true;
+        }
+        close(fd);
+    }
+    if (reader.overflow) {
+        std::cerr << "error: input file is too large: " << path << "\n";
+        return std::nullopt;
+    }
+    reader.finish();
+    return result;
+}
+
+void WordListSummary::print(std::ostream& os, const std::string& path) const
+{
+    os << "warning: skipped " << skipped() << " of " << lines << " lines in " << path << ": "
+       << bad_length << " not 2-15 letters long, " << bad_letters << " with characters other than A-Z\n";
+    for (const auto& [lineno, text] : examples) {
+        os << "    line " << lineno << ": \"" << text << "\"\n";
+    }
+    if (examples.size() < skipped()) {
+        os << "    ...\n";
+    }
+}
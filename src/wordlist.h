@@ -0,0 +1,50 @@
+#pragma once
+
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Lines of a word list that were skipped while reading it.
+struct WordListSummary
+{
+    std::size_t lines       = 0; // non-empty lines read
+    std::size_t bad_length  = 0; // fewer than 2 or more than 15 letters
+    std::size_t bad_letters = 0; // characters other than a-z, A-Z
+    // the first few skipped lines: (line number, contents)
+    std::vector<std::pair<std::size_t, std::string>> examples;
+
+    std::size_t skipped() const noexcept { return bad_length + bad_letters; }
+    void print(std::ostream& os, const std::string& path) const;
+};
+
+// Upper case A-Z words stored back to back in one buffer, each NUL-terminated
+// so they can be handed straight to mafsa_builder_insert().
+struct WordList
+{
+    WordList() = default;
+    // `words` must already be valid: 2-15 letters, A-Z
+    explicit WordList(const std::vector<std::string>& words);
+
+    // Reads a word list with one word per line, mmap'ing plain files and
+    // streaming .gz files through zlib. Words are upper cased, invalid lines
+    // are skipped and counted in `summary`. Stops after `max_words` words.
+    static std::optional<WordList> read(const std::string& path, int max_words, WordListSummary& summary);
+
+    std::size_t size() const noexcept { return offsets_.size(); }
+    bool empty() const noexcept { return offsets_.empty(); }
+    const char* operator[](std::size_t i) const noexcept { return &chars_[offsets_[i]]; }
+    std::size_t length(std::size_t i) const noexcept { return lengths_[i]; }
+    std::string_view view(std::size_t i) const noexcept { return { (*this)[i], length(i) }; }
+
+private:
+    friend struct WordListReader;
+    std::vector<char>          chars_;
+    std::vector<std::uint32_t> offsets_;
+    std::vector<std::uint8_t>  lengths_;
+};
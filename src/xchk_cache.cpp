@@ -0,0 +1,86 @@
+#include "xchk_cache.h"
+#include <cstring>
+
+XChkCache::XChkCache(std::size_t capacity) : entries_{}, stripes_{}
+{
+    std::size_t n = kStripes;
+    while (n < capacity) {
+        n *= 2;
+    }
+    entries_.assign(n, Entry{0u, 0u, {}});
+}
+
+std::size_t XChkCache::slot(const char* frag, int len) const noexcept
+{
+    // FNV-1a
+    std::uint64_t hash = 14695981039346656037ull;
+    for (int i = 0; i < len; ++i) {
+        hash ^= static_cast<unsigned char>(frag[i]);
+        hash *= 1099511628211ull;
+    }
+    return (hash ^ (hash >> 32)) & (entries_.size() - 1);
+}
+
+bool XChkCache::lookup(const char* frag, int len, std::uint32_t& xchk) noexcept
+{
+    if (len <= 0 || len > kMaxLen) {
+        return false;
+    }
+    const std::size_t i = slot(frag, len);
+    auto& stripe = stripes_[i % kStripes];
+    std::lock_guard<std::mutex> guard{stripe.lock};
+    const auto& entry = entries_[i];
+    if (entry.len != len || memcmp(entry.frag, frag, static_cast<std::size_t>(len)) != 0) {
+        ++stripe.misses;
+        return false;
+    }
+    ++stripe.hits;
+    xchk = entry.xchk;
+    return true;
+}
+
+void XChkCache::store(const char* frag, int len, std::uint32_t xchk) noexcept
+{
+    if (len <= 0 || len > kMaxLen) {
+        return;
+    }
+    const std::size_t i = slot(frag, len);
+    std::lock_guard<std::mutex> guard{stripes_[i % kStripes].lock};
+    auto& entry = entries_[i];
+    entry.xchk = xchk;
+    entry.len  = static_cast<std::uint8_t>(len);
+    memcpy(entry.frag, frag, static_cast<std::size_t>(len));
+}
+
+void XChkCache::clear() noexcept
+{
+    for (std::size_t s = 0; s < kStripes; ++s) {
+        std::lock_guard<std::mutex> guard{stripes_[s].lock};
+        for (std::size_t i = s; i < entries_.size(); i += kStripes) {
+            entries_[i].len = 0;
+        }
+        stripes_[s].hits   = 0;
+        stripes_[s].misses = 0;
+    }
+}
+
+XChkCache::Stats XChkCache::stats() const noexcept
+{
+    Stats result{0, 0};
+    for (auto& stripe : stripes_) {
+        std::lock_guard<std::mutex> guard{stripe.lock};
+        result.hits   += stripe.hits;
+        result.misses += stripe.misses;
+    }
+    return result;
+}
+
+int XChkCache::cicero_lookup(void* data, const char* frag, int len, std::uint32_t* xchk)
+{
+    return reinterpret_cast<XChkCache*>(data)->lookup(frag, len, *xchk) ? 1 : 0;
+}
+
+void XChkCache::cicero_store(void* data, const char* frag, int len, std::uint32_t xchk)
+{
+    reinterpret_cast<XChkCache*>(data)->store(frag, len, xchk);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include <cicero/cicero.h>
+
+// Bounded memo of cross-check sets by the fragment around the square, meant
+// to be shared by the engines of a simulation, possibly on several threads.
+// Direct-mapped: a fragment replaces whatever hashed to its slot before, and
+// the whole fragment is kept so colliding fragments are told apart. Slots are
+// guarded by a fixed number of striped locks.
+struct XChkCache
+{
+    struct Stats
+    {
+        std::uint64_t hits;
+        std::uint64_t misses;
+    };
+
+    // room for `capacity` fragments, rounded up to a power of 2
+    explicit XChkCache(std::size_t capacity);
+    XChkCache(const XChkCache&) = delete;
+    XChkCache& operator=(const XChkCache&) = delete;
+
+    bool lookup(const char* frag, int len, std::uint32_t& xchk) noexcept;
+    void store(const char* frag, int len, std::uint32_t xchk) noexcept;
+    // forgets all the fragments and resets the counters
+    void clear() noexcept;
+
+    Stats stats() const noexcept;
+    std::size_t capacity() const noexcept { return entries_.size(); }
+
+    // cicero_callbacks::xchklookup and xchkstore, `data` is the XChkCache
+    static int  cicero_lookup(void* data, const char* frag, int len, std::uint32_t* xchk);
+    static void cicero_store(void* data, const char* frag, int len, std::uint32_t xchk);
+
+private:
+    static constexpr int         kMaxLen = 15;
+    static constexpr std::size_t kStripes = 64;
+
+    struct Entry
+    {
+        std::uint32_t xchk;
+        std::uint8_t  len; // 0 if unused
+        char          frag[kMaxLen];
+    };
+
+    // counted under the stripe's lock
+    struct alignas(64) Stripe
+    {
+        std::mutex    lock;
+        std::uint64_t hits   = 0;
+        std::uint64_t misses = 0;
+    };
+
+    std::size_t slot(const char* frag, int len) const noexcept;
+
+    std::vector<Entry>                   entries_;
+    mutable std::array<Stripe, kStripes> stripes_;
+};
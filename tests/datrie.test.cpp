@@ -0,0 +1,164 @@
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <filesystem>
+#include <datrie.h>
+#include <mafsa++.h>
+#include "test_helpers.h"
+
+static Mafsa make_dict(MafsaType type, const std::vector<std::string>& words = DICT)
+{
+    MafsaBuilder builder;
+    for (const auto& word : words) {
+        REQUIRE((type == MafsaType::eGaddag ? builder.insert_gaddag(word) : builder.insert(word)));
+    }
+    auto result = builder.finish();
+    REQUIRE(result);
+    return std::move(*result);
+}
+
+static cicero_edges datrie_prefix_edges(void* data, const char* prefix) noexcept
+{
+    cicero_edges out;
+    auto edges = reinterpret_cast<const DATrie*>(data)->get_edges(prefix);
+    static_assert(sizeof(edges) == sizeof(out));
+    memcpy(&out, &edges, sizeof(out));
+    return out;
+}
+
+TEST_CASE("DATrie check word")
+{
+    const Mafsa m = make_dict(MafsaType::eDawg);
+    auto t = DATrie::build(m);
+    REQUIRE(t);
+    for (const auto& word : DICT) {
+        INFO("Checking " << word);
+        CHECK(t->isword(word));
+    }
+    for (const auto& word : MISSING) {
+        CHECK(!t->isword(word));
+    }
+    CHECK(!t->isword(""));
+    CHECK(!t->isword("AB-"));
+    CHECK(t->num_states() == m->nstates);
+}
+
+TEST_CASE("DATrie edges match Mafsa")
+{
+    for (auto type : { MafsaType::eDawg, MafsaType::eGaddag }) {
+        const Mafsa m = make_dict(type);
+        auto t = DATrie::build(m);
+        REQUIRE(t);
+
+        // every prefix of every word (and its GADDAG paths), plus some misses
+        std::vector<std::string> prefixes = { "", "Q", "ZZ", "QX" };
+        for (const auto& word : DICT) {
+            for (std::size_t n = 0; n <= word.size(); ++n) {
+                prefixes.push_back(word.substr(0, n));
+                std::string rev{word.rbegin(), word.rbegin() + static_cast<long>(n)};
+                prefixes.push_back(rev);
+                prefixes.push_back(rev + "^");
+            }
+        }
+        for (const auto& prefix : prefixes) {
+            INFO("Prefix " << prefix);
+            const auto expect = m.get_edges(prefix);
+            const auto actual = t->get_edges(prefix);
+            CHECK(actual.terminal == expect.terminal);
+            CHECK(std::string{actual.edges} == std::string{expect.edges});
+        }
+    }
+}
+
+TEST_CASE("DATrie native file format")
+{
+    const auto path = (std::filesystem::temp_directory_path() / "cicero-datrie-test.dict").string();
+    const Mafsa m = make_dict(MafsaType::eDawg);
+    auto built = DATrie::build(m);
+    REQUIRE(built);
+    REQUIRE(built->save(path));
+
+    SECTION("Loaded dictionary is identical")
+    {
+        auto loaded = DATrie::load(path);
+        REQUIRE(loaded);
+        CHECK(loaded->num_states() == built->num_states());
+        CHECK(loaded->num_slots() == built->num_slots());
+        for (const auto& word : DICT) {
+            INFO("Checking " << word);
+            CHECK(loaded->isword(word));
+        }
+        for (const auto& word : MISSING) {
+            CHECK(!loaded->isword(word));
+        }
+
+        // still valid after a move
+        DATrie moved{std::move(*loaded)};
+        CHECK(moved.isword(DICT.front()));
+    }
+
+    SECTION("Type must match")
+    {
+        CHECK(!DATrie::load(path, MafsaType::eGaddag));
+    }
+
+    SECTION("Not a double-array file")
+    {
+        REQUIRE(m.save(path));
+        CHECK(!DATrie::load(path));
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Move generation on DATrie matches Mafsa", "[gaddag]")
+{
+    auto cb = make_callbacks();
+    const Mafsa dawg = make_dict(MafsaType::eDawg);
+    const Mafsa gaddag = make_dict(MafsaType::eGaddag);
+    auto dawg_trie = DATrie::build(dawg);
+    auto gaddag_trie = DATrie::build(gaddag);
+    REQUIRE(dawg_trie);
+    REQUIRE(gaddag_trie);
+
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+    cicero trie_engine;
+    auto trie_cb = cb.make_callbacks();
+    trie_cb.lexicon = dawg_trie->lexicon();
+    trie_cb.gaddag = gaddag_trie->lexicon();
+    trie_cb.getedges = &datrie_prefix_edges;
+    trie_cb.getedgesdata = &*dawg_trie;
+    cicero_init(&trie_engine, trie_cb);
+
+    // clang-format off
+    const std::vector<std::string> racks = {
+        "AEINRST",
+        "EORSTU?",
+        "QUIZ?AE",
+        "??ABCDE",
+        "LLAMOSS",
+    };
+    // clang-format on
+
+    auto check_lexicons_agree = [&]()
+    {
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves(&engine, rack);
+            auto expect = cb.sorted_legal_moves();
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves(&trie_engine, rack);
+            CHECK(cb.sorted_legal_moves() == expect);
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves_gaddag(&trie_engine, rack);
+            CHECK(cb.sorted_legal_moves() == expect);
+        }
+    };
+
+    for_each_position({ &engine, &trie_engine }, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_lexicons_agree();
+    });
+}
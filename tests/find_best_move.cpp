@@ -73,12 +73,6 @@ void run(std::ifstream& ifs, Callbacks& cb)
     auto moves = cb.sorted_legal_moves();
     int i = 0;
 
-    for (auto& move : moves) {
-        auto emove = scrabble::EngineMove::make(&engine, move);
-        auto score = cicero_score_move(&engine, &emove.move);
-        move.score = score;
-    }
-
     std::sort(moves.begin(), moves.end(), [](const auto& m1, const auto& m2) {
             return m1.score > m2.score; });
 
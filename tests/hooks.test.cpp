@@ -0,0 +1,169 @@
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <functional>
+#include <hooks.h>
+#include <mafsa++.h>
+#include "test_helpers.h"
+
+static Mafsa make_dict(const std::vector<std::string>& words = DICT)
+{
+    MafsaBuilder builder;
+    for (const auto& word : words) {
+        REQUIRE(builder.insert(word));
+    }
+    auto result = builder.finish();
+    REQUIRE(result);
+    return std::move(*result);
+}
+
+static void check_hooks(const HookIndex& index, const std::function<bool(const std::string&)>& isword,
+                        const std::vector<std::string>& words)
+{
+    // every infix of every word, so that both words and non-words are looked up
+    std::vector<std::string> fragments;
+    for (const auto& word : words) {
+        for (std::size_t pos = 0; pos < word.size(); ++pos) {
+            for (std::size_t n = 1; pos + n <= word.size(); ++n) {
+                fragments.push_back(word.substr(pos, n));
+            }
+        }
+    }
+    for (const auto& fragment : fragments) {
+        INFO("Fragment " << fragment);
+        HookIndex::Hooks hooks;
+        const bool found = index.lookup(fragment.c_str(), static_cast<int>(fragment.size()), hooks);
+        // words of other lexicons may be found too, with this lexicon's hooks
+        if (fragment.size() == 1 || isword(fragment)) {
+            REQUIRE(found);
+        } else if (!found) {
+            continue;
+        }
+        std::uint32_t front = 0;
+        std::uint32_t back  = 0;
+        for (char c = 'A'; c <= 'Z'; ++c) {
+            if (isword(c + fragment)) {
+                front |= 1u << (c - 'A');
+            }
+            if (isword(fragment + c)) {
+                back |= 1u << (c - 'A');
+            }
+        }
+        CHECK(hooks.front == front);
+        CHECK(hooks.back == back);
+    }
+}
+
+TEST_CASE("Hook index matches dictionary")
+{
+    const Mafsa m = make_dict();
+    const auto index = HookIndex::build(m);
+    CHECK(index.num_words() == DICT.size());
+    check_hooks(index, [&](const std::string& word) { return m.isword(word); }, DICT);
+
+    HookIndex::Hooks hooks;
+    CHECK(!index.lookup("", 0, hooks));
+    CHECK(!index.lookup("a", 1, hooks));
+    CHECK(!index.lookup("AB-", 3, hooks));
+    CHECK(!index.lookup("QX", 2, hooks));
+    CHECK(!index.lookup("ZAGX", 4, hooks));
+}
+
+TEST_CASE("Hook index of one lexicon of a shared dictionary")
+{
+    // lexicon 0 adds hooks to some of DICT's words, they must not leak into
+    // lexicon 1
+    const std::vector<std::string> other = { "ZA", "QI", "XU", "AE", "OE", "ZAG", "BAMS", "CARTS", "SCARE" };
+    const std::vector<WordList> lexicons = { WordList{other}, WordList{DICT} };
+    auto dawg = MafsaBuilder::build_lexicons(lexicons, MafsaType::eDawg);
+    REQUIRE(dawg);
+
+    for (int lexicon = 0; lexicon < 2; ++lexicon) {
+        INFO("Lexicon " << lexicon);
+        const auto index = HookIndex::build(*dawg, lexicon);
+        auto isword = [&](const std::string& word) { return dawg->isword(word, lexicon); };
+        check_hooks(index, isword, DICT);
+        check_hooks(index, isword, other);
+    }
+}
+
+TEST_CASE("Move generation with hook index matches without")
+{
+    // the played words and some of their hooks, so the hooks are used
+    auto words = DICT;
+    for (const auto& word : {
+            "ZAG", "ZAGS", "BAM", "BAMS", "TAG", "TAGS", "STAG", "TRAM", "TRAMS", "OD", "ODS", "GOD",
+            "ARENITE", "ARENITES", "PEDANTS", "YO", "YOB", "YOD", "JIB", "JIBS", "TOECLIP", "TOECLIPS",
+            "OHS", "QAT", "QATS", "AB", "BA", "TA", "AT", "IT", "TI", "MA", "AM", "ZA", "QI", "OE", "OX" }) {
+        words.emplace_back(word);
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    auto cb = make_callbacks(words);
+    const Mafsa m = make_dict(words);
+    const auto index = HookIndex::build(m);
+
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+    cicero hooks_engine;
+    // counts the lookups, so the hooks can't go unused next to the GADDAG
+    struct Counted
+    {
+        const HookIndex* index;
+        int calls;
+    } counted = { &index, 0 };
+    auto hooks_cb = cb.make_callbacks();
+    hooks_cb.hooks = [](const void* data, const char* word, int len, std::uint32_t* front, std::uint32_t* back)
+    {
+        auto* c = static_cast<Counted*>(const_cast<void*>(data));
+        ++c->calls;
+        return HookIndex::cicero_hooks(c->index, word, len, front, back);
+    };
+    hooks_cb.hooksdata = &counted;
+    REQUIRE(hooks_cb.gaddag.root != nullptr);
+    cicero_init(&hooks_engine, hooks_cb);
+
+    // clang-format off
+    const std::vector<std::string> racks = {
+        "AEINRST",
+        "EORSTU?",
+        "QUIZ?AE",
+        "??ABCDE",
+    };
+    // clang-format on
+
+    auto check_engines_agree = [&]()
+    {
+        CHECK(memcmp(engine.hchk, hooks_engine.hchk, sizeof(engine.hchk)) == 0);
+        CHECK(memcmp(engine.vchk, hooks_engine.vchk, sizeof(engine.vchk)) == 0);
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves(&engine, rack);
+            auto expect = cb.sorted_legal_moves();
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves(&hooks_engine, rack);
+            CHECK(cb.sorted_legal_moves() == expect);
+        }
+    };
+
+    for_each_position({ &engine, &hooks_engine }, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_engines_agree();
+    });
+
+    // positions are loaded with the same cross-checks
+    char board[225];
+    for (int sq = 0; sq < 225; ++sq) {
+        board[sq] = cicero_tile_on_square(&engine, sq);
+    }
+    cicero loaded;
+    cicero_init(&loaded, cb.make_callbacks());
+    cicero_load_position(&loaded, board);
+    cicero hooks_loaded;
+    cicero_init(&hooks_loaded, hooks_cb);
+    cicero_load_position(&hooks_loaded, board);
+    CHECK(memcmp(loaded.hchk, hooks_loaded.hchk, sizeof(loaded.hchk)) == 0);
+    CHECK(memcmp(loaded.vchk, hooks_loaded.vchk, sizeof(loaded.vchk)) == 0);
+    CHECK(counted.calls > 0);
+}
@@ -0,0 +1,88 @@
+#include <catch2/catch.hpp>
+#include <lane_cache.h>
+#include "test_helpers.h"
+
+TEST_CASE("Move generation from the lane cache matches generating every lane")
+{
+    auto cb = make_callbacks();
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+
+    // clang-format off
+    const std::vector<std::string> racks = {
+        "AEINRST",
+        "EORSTU?",
+        "??ABCDE",
+    };
+    // clang-format on
+
+    LaneMoveCache cache{4096};
+    std::vector<cicero_move_record> all(1 << 14);
+    cicero_move_sink sink;
+    sink.moves = all.data();
+    sink.cap = static_cast<int>(all.size());
+
+    auto check_cache = [&]()
+    {
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            sink.skip = 0;
+            cicero_generate_legal_moves_into(&engine, rack, &sink);
+            REQUIRE(sink.len == sink.total);
+            const auto& moves = cache.generate(&engine, rack);
+            REQUIRE(moves.size() == static_cast<std::size_t>(sink.len));
+            for (std::size_t i = 0; i < moves.size(); ++i) {
+                CHECK(cicero_compare_move_records(&moves[i], &all[i]) == 0);
+                CHECK(moves[i].score == all[i].score);
+                CHECK(moves[i].second == all[i].second);
+            }
+        }
+    };
+
+    // the same position again is all hits
+    check_cache();
+    const auto first = cache.stats();
+    CHECK(first.hits == 0);
+    CHECK(first.misses > 0);
+    check_cache();
+    CHECK(cache.stats().hits == first.misses);
+    CHECK(cache.stats().misses == first.misses);
+
+    std::vector<cicero_savepos> sps(ISC_MOVES.size());
+    std::vector<scrabble::EngineMove> played;
+    played.reserve(ISC_MOVES.size()); // cicero_move points into its EngineMove
+    for (const auto& isc_move : ISC_MOVES) {
+        INFO("After " << isc_move);
+        auto move = scrabble::Move::from_isc_spec(isc_move);
+        played.push_back(scrabble::EngineMove::make(&engine, move));
+        const auto before = cache.stats();
+        cicero_make_move(&engine, &sps[played.size() - 1], &played.back().move);
+        check_cache();
+        // a move leaves some of the lanes as they were, once there are tiles
+        // on more than one of them
+        if (played.size() > 1) {
+            CHECK(cache.stats().hits > before.hits);
+        }
+    }
+
+    // undoing the moves goes back through positions that were seen already
+    const auto before = cache.stats();
+    while (!played.empty()) {
+        cicero_undo_move(&engine, &sps[played.size() - 1], &played.back().move);
+        played.pop_back();
+        check_cache();
+    }
+    CHECK(cache.stats().misses == before.misses);
+
+    // a cache that can't keep many lanes starts over, and stays right
+    LaneMoveCache small{40};
+    for (const auto& tiles : racks) {
+        auto rack = make_rack(tiles);
+        small.generate(&engine, rack);
+        CHECK(small.size() <= 40);
+    }
+    cache.clear();
+    CHECK(cache.size() == 0);
+    CHECK(cache.stats().hits == 0);
+}
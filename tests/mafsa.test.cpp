@@ -1,5 +1,12 @@
 #include <catch2/catch.hpp>
+#include <cstring>
+#include <algorithm>
+#include <atomic>
+#include <filesystem>
+#include <thread>
+#include <unordered_set>
 #include <mafsa/mafsa.h>
+#include <mafsa++.h>
 #include "test_data.h"
 
 mafsa make_mafsa(const std::vector<std::string>& words = DICT)
@@ -54,6 +61,7 @@ TEST_CASE("Mafsa edges")
         CHECK(es.edges[2] == 'D');
         CHECK(es.edges[3] == 'Z');
         CHECK(es.edges[4] == '\0');
+        CHECK(mafsa_prefix_mask(&m, "AB") == ((1u << 0) | (1u << 1) | (1u << 3) | (1u << 25)));
     }
 
     SECTION("Prefix ABE has no edges")
@@ -63,6 +71,7 @@ TEST_CASE("Mafsa edges")
         mafsa_edges es = mafsa_prefix_edges(&m, prefix);
         CHECK(es.terminal == false);
         CHECK(es.edges[0] == '\0');
+        CHECK(mafsa_prefix_mask(&m, prefix) == 0u);
     }
 
     SECTION("Prefix ABA has edges and is terminal")
@@ -78,3 +87,287 @@ TEST_CASE("Mafsa edges")
 
     mafsa_free(&m);
 }
+
+TEST_CASE("Mafsa cursor")
+{
+    const std::vector<std::string> words = {
+        "ABA",
+        "ABAS",
+        "ABB",
+        "ABD",
+        "GOO",
+    };
+    mafsa m = make_mafsa(words);
+
+    auto walk = [&m](const char* prefix) {
+        int s = mafsa_root(&m);
+        for (const char* p = prefix; *p != '\0'; ++p) {
+            const int c = *p - 'A';
+            REQUIRE((mafsa_edgemask(&m, s) & (1u << c)) != 0);
+            s = mafsa_child(&m, s, c);
+        }
+        return s;
+    };
+
+    SECTION("Root edges")
+    {
+        CHECK(mafsa_edgemask(&m, mafsa_root(&m)) == ((1u << ('A' - 'A')) | (1u << ('G' - 'A'))));
+        CHECK(mafsa_isterm(&m, mafsa_root(&m)) == 0);
+    }
+
+    SECTION("Cursor agrees with prefix edges")
+    {
+        for (const char* prefix : { "AB", "ABA", "ABAS", "GO", "GOO" }) {
+            INFO("Checking " << prefix);
+            const int s = walk(prefix);
+            mafsa_edges es = mafsa_prefix_edges(&m, prefix);
+            unsigned int mask = 0;
+            for (const char* e = es.edges; *e != '\0'; ++e) {
+                mask |= 1u << (*e - 'A');
+            }
+            CHECK(mafsa_edgemask(&m, s) == mask);
+            CHECK(mafsa_isterm(&m, s) == es.terminal);
+            CHECK(mafsa_prefix_mask(&m, prefix) == (mask | (es.terminal ? MAFSA_TERM : 0u)));
+        }
+    }
+
+    mafsa_free(&m);
+}
+
+TEST_CASE("Mafsa packed layout")
+{
+    mafsa m = make_mafsa();
+
+    int nstates = 0;
+    int s = 0;
+    while (s < m.size) {
+        INFO("Checking state " << s);
+        const unsigned int edges = mafsa_edgemask(&m, s);
+        CHECK((m.data[s] & MAFSA_EDGES) == edges);
+        // a plain build only has lexicon 0
+        CHECK((m.data[s] & MAFSA_LEXICONS) == (mafsa_isterm(&m, s) ? 1u << MAFSA_LEXSHIFT : 0u));
+        int arc = s + 1;
+        for (int c = 0; c < MAFSA_NEDGES; ++c) {
+            if ((edges & (1u << c)) != 0) {
+                const int t = mafsa_child(&m, s, c);
+                CHECK(m.data[arc] >> MAFSA_LEXSHIFT == 1u);
+                CHECK(t == static_cast<int>(m.data[arc++] & MAFSA_OFFSET));
+                CHECK((0 < t && t < m.size));
+            }
+        }
+        s = arc;
+        ++nstates;
+    }
+    CHECK(s == m.size);
+    CHECK(nstates == m.nstates);
+
+    mafsa_free(&m);
+}
+
+TEST_CASE("Mafsa is minimal")
+{
+    SECTION("Shared suffixes")
+    {
+        // root -> {B,C,R} -> A -> T -> S -> final
+        mafsa m = make_mafsa({ "BATS", "CATS", "RATS" });
+        CHECK(m.nstates == 5);
+        mafsa_free(&m);
+    }
+
+    SECTION("Shared suffixes with final states")
+    {
+        // root -> T -> {A,O} -> P (final) -> S -> final
+        mafsa m = make_mafsa({ "TAP", "TAPS", "TOP", "TOPS" });
+        CHECK(m.nstates == 5);
+        CHECK(mafsa_isword(&m, "TOP") != 0);
+        CHECK(mafsa_isword(&m, "TO") == 0);
+        mafsa_free(&m);
+    }
+}
+
+TEST_CASE("Mafsa native file format")
+{
+    const auto path = (std::filesystem::temp_directory_path() / "cicero-mafsa-test.dict").string();
+    MafsaBuilder builder;
+    for (const auto& word : DICT) {
+        REQUIRE(builder.insert(word));
+    }
+    auto built = builder.finish();
+    REQUIRE(built);
+    REQUIRE(built->save(path));
+
+    SECTION("Loaded dictionary is identical")
+    {
+        auto loaded = Mafsa::load(path);
+        REQUIRE(loaded);
+        REQUIRE((*loaded)->size == (*built)->size);
+        CHECK((*loaded)->nstates == (*built)->nstates);
+        CHECK(memcmp((*loaded)->data, (*built)->data, sizeof((*built)->data[0]) * static_cast<size_t>((*built)->size)) == 0);
+        for (const auto& word : DICT) {
+            INFO("Checking " << word);
+            CHECK(loaded->isword(word));
+        }
+        for (const auto& word : MISSING) {
+            CHECK(!loaded->isword(word));
+        }
+
+        // still valid after a move
+        Mafsa moved{std::move(*loaded)};
+        CHECK(moved.isword(DICT.front()));
+    }
+
+    SECTION("Type must match")
+    {
+        CHECK(!Mafsa::load(path, MafsaType::eGaddag));
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Mafsa concurrent saves to one path")
+{
+    const auto dir  = std::filesystem::temp_directory_path() / "cicero-mafsa-save-test";
+    const auto path = (dir / "shared.dict").string();
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directory(dir);
+    MafsaBuilder builder;
+    for (const auto& word : DICT) {
+        REQUIRE(builder.insert(word));
+    }
+    auto built = builder.finish();
+    REQUIRE(built);
+
+    std::vector<std::thread> threads;
+    std::atomic<int> saved{0};
+    for (int i = 0; i < 8; ++i) {
+        threads.emplace_back([&]() {
+            for (int j = 0; j < 16; ++j) {
+                saved += built->save(path) ? 1 : 0;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    CHECK(saved == 8 * 16);
+
+    auto loaded = Mafsa::load(path);
+    REQUIRE(loaded);
+    CHECK((*loaded)->size == (*built)->size);
+    // every temporary was renamed into place
+    CHECK(std::distance(std::filesystem::directory_iterator{dir}, std::filesystem::directory_iterator{}) == 1);
+
+    std::filesystem::remove_all(dir);
+}
+
+static void all_words(const mafsa& m, int s, std::string& prefix, std::vector<std::string>& out)
+{
+    if (mafsa_isterm(&m, s)) {
+        out.push_back(prefix);
+    }
+    for (int c = 0; c < MAFSA_NEDGES; ++c) {
+        if ((mafsa_edgemask(&m, s) & (1u << c)) != 0) {
+            prefix.push_back(c == MAFSA_SEP ? '^' : static_cast<char>('A' + c));
+            all_words(m, mafsa_child(&m, s, c), prefix, out);
+            prefix.pop_back();
+        }
+    }
+}
+
+TEST_CASE("Mafsa sharded build matches sequential build")
+{
+    for (auto type : { MafsaType::eDawg, MafsaType::eGaddag }) {
+        MafsaBuilder builder;
+        for (const auto& word : DICT) {
+            REQUIRE((type == MafsaType::eGaddag ? builder.insert_gaddag(word) : builder.insert(word)));
+        }
+        auto expect = builder.finish();
+        REQUIRE(expect);
+        std::string prefix;
+        std::vector<std::string> expect_words;
+        all_words(**expect, 0, prefix, expect_words);
+
+        for (int threads : { 2, 3, 8, 64 }) {
+            INFO("Checking " << (type == MafsaType::eGaddag ? "GADDAG" : "DAWG") << " with " << threads << " threads");
+            auto sharded = MafsaBuilder::build_sharded(WordList{DICT}, type, threads);
+            REQUIRE(sharded);
+            CHECK((*sharded)->nstates == (*expect)->nstates);
+            CHECK((*sharded)->size == (*expect)->size);
+            std::vector<std::string> words;
+            all_words(**sharded, 0, prefix, words);
+            CHECK(words == expect_words);
+        }
+    }
+}
+
+TEST_CASE("Mafsa with several lexicons")
+{
+    // lexicon 0 is DICT, lexicon 1 every other word of it plus a few more,
+    // lexicon 2 is empty
+    std::vector<std::string> second;
+    for (std::size_t i = 0; i < DICT.size(); i += 2) {
+        second.push_back(DICT[i]);
+    }
+    const std::vector<std::string> extra = { "ZZXQ", "AAAAB", "QOPH" };
+    second.insert(second.end(), extra.begin(), extra.end());
+    std::vector<WordList> lexicons = { WordList{DICT}, WordList{second}, WordList{} };
+    const std::unordered_set<std::string> in_second{second.begin(), second.end()};
+
+    for (auto type : { MafsaType::eDawg, MafsaType::eGaddag }) {
+        INFO("Checking " << (type == MafsaType::eGaddag ? "GADDAG" : "DAWG"));
+        auto reverse = [type](std::string word) {
+            if (type == MafsaType::eGaddag) {
+                std::reverse(word.begin(), word.end());
+            }
+            return word;
+        };
+        for (int threads : { 1, 3 }) {
+            auto m = MafsaBuilder::build_lexicons(lexicons, type, threads);
+            REQUIRE(m);
+            for (const auto& word : DICT) {
+                INFO("Checking " << word);
+                CHECK(m->isword(reverse(word), 0));
+                CHECK(m->isword(reverse(word), 1) == (in_second.count(word) != 0));
+                CHECK(!m->isword(reverse(word), 2));
+            }
+            for (const auto& word : extra) {
+                CHECK(!m->isword(reverse(word), 0));
+                CHECK(m->isword(reverse(word), 1));
+                CHECK(m->isword(reverse(word)));
+            }
+
+            // edges lead only to words of the lexicon
+            const auto zzxq = reverse("ZZXQ");
+            CHECK(std::string{m->get_edges(zzxq.substr(0, 3), 1).edges} == zzxq.substr(3));
+            CHECK(std::string{m->get_edges(zzxq.substr(0, 3), 0).edges}.empty());
+            CHECK(m->get_edges(zzxq, 1).terminal);
+            CHECK(!m->get_edges(zzxq, 0).terminal);
+            const auto all = m->get_edges("", 0);
+            CHECK(std::string{m->get_edges("", 2).edges}.empty());
+            CHECK(!std::string{all.edges}.empty());
+            CHECK(mafsa_prefix_mask_in(&**m, zzxq.c_str(), 1) == MAFSA_TERM);
+            CHECK(mafsa_prefix_mask_in(&**m, zzxq.c_str(), 0) == 0u);
+
+            // the cursor of a lexicon has its own terminal bit
+            const auto lex = m->lexicon(1);
+            int node = lex.root(lex.data);
+            for (char c : zzxq) {
+                node = lex.child(lex.data, node, c - 'A');
+            }
+            CHECK(lex.edges(lex.data, node) == CICERO_TERMINAL);
+            CHECK((m->lexicon(0).edges(lex.data, node) & CICERO_TERMINAL) == 0u);
+
+            // no bigger than the union of the lexicons in a single one
+            MafsaBuilder builder;
+            for (const auto& words : { DICT, second }) {
+                for (const auto& word : words) {
+                    REQUIRE((type == MafsaType::eGaddag ? builder.insert_gaddag(word) : builder.insert(word)));
+                }
+            }
+            auto both = builder.finish();
+            REQUIRE(both);
+            CHECK((*m)->size >= (*both)->size);
+            CHECK((*m)->size < 2 * (*both)->size);
+        }
+    }
+}
@@ -0,0 +1,228 @@
+// Compares the packed MA-FSA node layout against the old layout of one
+// `int children[MAFSA_NEDGES]` array per state: memory used, word lookups,
+// and a full depth-first walk of the automaton (the access pattern of move
+// generation). The double-array trie built from the same automaton is
+// measured alongside, and so is building the DAWG and GADDAG on a few threads.
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <climits>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <datrie.h>
+#include <mafsa++.h>
+
+
+struct UnpackedMafsa
+{
+    explicit UnpackedMafsa(const mafsa& m)
+        : nodes(static_cast<std::size_t>(m.nstates))
+        , terms(static_cast<std::size_t>(m.nstates) / 32 + 1, 0u)
+    {
+        // packed states are offsets, number them densely in the same order
+        std::vector<int> index(static_cast<std::size_t>(m.size), 0);
+        std::vector<int> states;
+        for (int s = 0; s < m.size; s += 1 + __builtin_popcount(mafsa_edgemask(&m, s))) {
+            index[static_cast<std::size_t>(s)] = static_cast<int>(states.size());
+            states.push_back(s);
+        }
+        for (std::size_t idx = 0; idx < states.size(); ++idx) {
+            const int s = states[idx];
+            nodes[idx].fill(0);
+            for (int c = 0; c < MAFSA_NEDGES; ++c) {
+                if ((mafsa_edgemask(&m, s) & (1u << c)) != 0) {
+                    const int t = mafsa_child(&m, s, c);
+                    nodes[idx][static_cast<std::size_t>(c)] = index[static_cast<std::size_t>(t)];
+                }
+            }
+            if (mafsa_isterm(&m, s)) {
+                terms[idx / 32] |= 1u << (idx % 32);
+            }
+        }
+    }
+
+    bool isterm(int s) const noexcept
+    {
+        const auto idx = static_cast<std::size_t>(s);
+        return (terms[idx / 32] & (1u << (idx % 32))) != 0;
+    }
+
+    bool isword(const std::string& word) const noexcept
+    {
+        int s = 0;
+        for (char ch : word) {
+            s = nodes[static_cast<std::size_t>(s)][static_cast<std::size_t>(ch - 'A')];
+            if (s == 0) {
+                return false;
+            }
+        }
+        return isterm(s);
+    }
+
+    std::size_t bytes() const noexcept
+    {
+        return nodes.size() * sizeof(nodes[0]) + terms.size() * sizeof(terms[0]);
+    }
+
+    std::vector<std::array<int, MAFSA_NEDGES>> nodes;
+    std::vector<unsigned int> terms;
+};
+
+static long walk_packed(const mafsa& m, int s)
+{
+    long words = mafsa_isterm(&m, s);
+    unsigned int edges = mafsa_edgemask(&m, s);
+    while (edges != 0) {
+        const int c = __builtin_ctz(edges);
+        edges &= edges - 1;
+        words += walk_packed(m, mafsa_child(&m, s, c));
+    }
+    return words;
+}
+
+static long walk_unpacked(const UnpackedMafsa& m, int s)
+{
+    long words = m.isterm(s) ? 1 : 0;
+    for (int t : m.nodes[static_cast<std::size_t>(s)]) {
+        if (t != 0) {
+            words += walk_unpacked(m, t);
+        }
+    }
+    return words;
+}
+
+static long walk_datrie(const DATrie& t, int s)
+{
+    long words = t.isterm(s) ? 1 : 0;
+    unsigned int edges = t.edges(s);
+    while (edges != 0) {
+        const int c = __builtin_ctz(edges);
+        edges &= edges - 1;
+        words += walk_datrie(t, t.child(s, c));
+    }
+    return words;
+}
+
+template <class F>
+static double time_ms(int reps, F&& f)
+{
+    using clock = std::chrono::steady_clock;
+    auto best = std::chrono::duration<double, std::milli>::max();
+    for (int i = 0; i < reps; ++i) {
+        const auto start = clock::now();
+        f();
+        best = std::min<std::chrono::duration<double, std::milli>>(best, clock::now() - start);
+    }
+    return best.count();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " [WORD LIST] [REPS]" << std::endl;
+        return 1;
+    }
+    const std::string path = argv[1];
+    const int         reps = argc >= 3 ? std::max(1, atoi(argv[2])) : 5;
+
+    std::vector<std::string> words;
+    {
+        std::ifstream ifs{path};
+        std::string word;
+        while (ifs >> word) {
+            if (word.size() < 2 || word.size() > 15) {
+                continue;
+            }
+            std::transform(word.begin(), word.end(), word.begin(), ::toupper);
+            words.push_back(word);
+        }
+    }
+    // mix in non-words that share prefixes with real words
+    std::vector<std::string> queries = words;
+    for (const auto& word : words) {
+        auto miss = word;
+        miss.back() = miss.back() == 'Z' ? 'Q' : static_cast<char>(miss.back() + 1);
+        queries.push_back(miss);
+    }
+    std::shuffle(queries.begin(), queries.end(), std::mt19937{42});
+
+    auto maybe_dict = Mafsa::load(path);
+    if (!maybe_dict) {
+        std::cerr << "error: unable to load dictionary: " << path << std::endl;
+        return 1;
+    }
+    const Mafsa& packed = *maybe_dict;
+    const UnpackedMafsa unpacked{*packed};
+    auto maybe_datrie = DATrie::build(packed);
+    if (!maybe_datrie) {
+        std::cerr << "error: unable to build double-array trie" << std::endl;
+        return 1;
+    }
+    const DATrie& datrie = *maybe_datrie;
+
+    const std::size_t packed_bytes = sizeof(packed->data[0]) * static_cast<std::size_t>(packed->size);
+
+    long found_packed = 0, found_unpacked = 0, found_datrie = 0;
+    const double lookup_packed = time_ms(reps, [&]() {
+        found_packed = 0;
+        for (const auto& q : queries) {
+            found_packed += packed.isword(q) ? 1 : 0;
+        }
+    });
+    const double lookup_unpacked = time_ms(reps, [&]() {
+        found_unpacked = 0;
+        for (const auto& q : queries) {
+            found_unpacked += unpacked.isword(q) ? 1 : 0;
+        }
+    });
+
+    const double lookup_datrie = time_ms(reps, [&]() {
+        found_datrie = 0;
+        for (const auto& q : queries) {
+            found_datrie += datrie.isword(q) ? 1 : 0;
+        }
+    });
+
+    long walked_packed = 0, walked_unpacked = 0, walked_datrie = 0;
+    const double walk_ms_packed   = time_ms(reps, [&]() { walked_packed   = walk_packed(*packed, 0); });
+    const double walk_ms_unpacked = time_ms(reps, [&]() { walked_unpacked = walk_unpacked(unpacked, 0); });
+    const double walk_ms_datrie   = time_ms(reps, [&]() { walked_datrie   = walk_datrie(datrie, datrie.root()); });
+
+    if (found_packed != found_unpacked || walked_packed != walked_unpacked ||
+        found_packed != found_datrie || walked_packed != walked_datrie) {
+        std::cerr << "error: layouts disagree" << std::endl;
+        return 1;
+    }
+
+    fmt::print("states: {}  arcs: {}  words: {}  queries: {}\n",
+            packed->nstates, packed->size - packed->nstates, walked_packed, queries.size());
+    fmt::print("{:<10} {:>12} {:>14} {:>12}\n", "layout", "memory (KiB)", "lookups (ms)", "walk (ms)");
+    fmt::print("{:<10} {:>12} {:>14.2f} {:>12.2f}\n", "unpacked", unpacked.bytes() / 1024,
+            lookup_unpacked, walk_ms_unpacked);
+    fmt::print("{:<10} {:>12} {:>14.2f} {:>12.2f}\n", "packed", packed_bytes / 1024,
+            lookup_packed, walk_ms_packed);
+    fmt::print("{:<10} {:>12} {:>14.2f} {:>12.2f}\n", "datrie", datrie.bytes() / 1024,
+            lookup_datrie, walk_ms_datrie);
+    fmt::print("datrie slots: {} ({:.1f}% used)\n", datrie.num_slots(),
+            100.0 * (packed->size - packed->nstates) / datrie.num_slots());
+
+    fmt::print("{:<10} {:>12} {:>14}\n", "threads", "DAWG (ms)", "GADDAG (ms)");
+    for (int threads : { 1, 2, 4, 8 }) {
+        const double dawg_ms = time_ms(reps, [&]() {
+            MafsaBuilder::build_from_file(path, INT_MAX, MafsaType::eDawg, threads);
+        });
+        const double gaddag_ms = time_ms(reps, [&]() {
+            MafsaBuilder::build_from_file(path, INT_MAX, MafsaType::eGaddag, threads);
+        });
+        fmt::print("{:<10} {:>12.2f} {:>14.2f}\n", threads, dawg_ms, gaddag_ms);
+    }
+    return 0;
+}
@@ -1,4 +1,9 @@
 #include <catch2/catch.hpp>
+#include <array>
+#include <cstring>
+#include <map>
+#include <set>
+#include <tuple>
 #include "test_helpers.h"
 
 
@@ -24,26 +29,26 @@ TEST_CASE("Cicero first moves")
         auto rack = make_rack("UNRYFIA");
         const std::vector<std::string> expect_isc = {
             // horizontal fry
-            { "H6 fry" },
-            { "H7 fry" },
-            { "H8 fry" },
+            { "H6 fry 18" },
+            { "H7 fry 18" },
+            { "H8 fry 18" },
             // vertical fry
-            { "8F fry" },
-            { "8G fry" },
-            { "8H fry" },
+            { "8F fry 18" },
+            { "8G fry 18" },
+            { "8H fry 18" },
 
             // horizontal unify
-            { "H4 unify" },
-            { "H5 unify" },
-            { "H6 unify" },
-            { "H7 unify" },
-            { "H8 unify" },
+            { "H4 unify 24" },
+            { "H5 unify 22" },
+            { "H6 unify 22" },
+            { "H7 unify 22" },
+            { "H8 unify 30" },
             // vertical unify
-            { "8D unify" },
-            { "8E unify" },
-            { "8F unify" },
-            { "8G unify" },
-            { "8H unify" },
+            { "8D unify 24" },
+            { "8E unify 22" },
+            { "8F unify 22" },
+            { "8G unify 22" },
+            { "8H unify 30" },
         };
         const auto expect = make_move_list(expect_isc);
         cicero_generate_legal_moves(&engine, rack);
@@ -56,17 +61,17 @@ TEST_CASE("Cicero first moves")
         auto rack = make_rack("APPL?ZW");
         std::vector<std::string> expect_isc = {
             // horizontal applE
-            { "H4 applE" },
-            { "H5 applE" },
-            { "H6 applE" },
-            { "H7 applE" },
-            { "H8 applE" },
+            { "H4 applE 18" },
+            { "H5 applE 16" },
+            { "H6 applE 16" },
+            { "H7 applE 16" },
+            { "H8 applE 16" },
             // vertical applE
-            { "8D applE" },
-            { "8E applE" },
-            { "8F applE" },
-            { "8G applE" },
-            { "8H applE" },
+            { "8D applE 18" },
+            { "8E applE 16" },
+            { "8F applE 16" },
+            { "8G applE 16" },
+            { "8H applE 16" },
         };
         auto expect = make_move_list(expect_isc);
         cicero_generate_legal_moves(&engine, rack);
@@ -86,7 +91,7 @@ TEST_CASE("Cicero first moves")
         cicero_make_move(&engine, &sp, &move);
 
         auto rack = make_rack("RDSELUU");
-        auto expect = scrabble::Move::from_isc_spec("11E sulfured");
+        auto expect = scrabble::Move::from_isc_spec("11E sulfured 98");
         cicero_generate_legal_moves(&engine, rack);
         auto legal_moves = cb.sorted_legal_moves();
         REQUIRE(legal_moves.size() == 1);
@@ -357,3 +362,418 @@ TEST_CASE("Convert cicero_move -> cicero_move2", "[cicero_move2]")
         }
     }
 }
+
+TEST_CASE("GADDAG move generation matches DAWG move generation", "[gaddag]")
+{
+    auto cb = make_callbacks();
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+
+    // clang-format off
+    const std::vector<std::string> racks = {
+        "AEINRST",
+        "EORSTU?",
+        "QUIZ?AE",
+        "??ABCDE",
+        "LLAMOSS",
+    };
+    // clang-format on
+
+    auto check_generators_agree = [&]()
+    {
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves(&engine, rack);
+            auto dawg_moves = cb.sorted_legal_moves();
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves_gaddag(&engine, rack);
+            auto gaddag_moves = cb.sorted_legal_moves();
+            CHECK(gaddag_moves == dawg_moves);
+        }
+    };
+
+    for_each_position(&engine, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_generators_agree();
+    });
+}
+
+TEST_CASE("Generating moves into a sink matches the callback", "[sink]")
+{
+    auto cb = make_callbacks();
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+
+    const std::vector<std::string> racks = { "AEINRST", "EORSTU?", "??ABCDE" };
+
+    auto record_to_move = [&engine](const cicero_move_record& rec)
+    {
+        scrabble::Move move;
+        move.square = scrabble::Square{rec.square};
+        move.direction = static_cast<scrabble::Direction>(rec.direction);
+        move.score = rec.score;
+        int ntiles = 0;
+        for (int i = 0; i < rec.length; ++i) {
+            const int sq = rec.square + i * rec.direction;
+            if (rec.tiles[i] == '.') {
+                move.word += cicero_tile_on_square(&engine, sq);
+            } else {
+                move.word += (rec.blanks & (1u << i)) != 0 ? static_cast<char>(tolower(rec.tiles[i])) : rec.tiles[i];
+                ++ntiles;
+            }
+        }
+        CHECK(rec.ntiles == ntiles);
+        CHECK(rec.tiles[rec.length] == '\0');
+        const auto move2 = cicero_move_record_to_move2(&rec);
+        CHECK(move2.square == rec.square);
+        CHECK(move2.direction == rec.direction);
+        CHECK(strlen(move2.tiles) == rec.length);
+        return move;
+    };
+
+    // a small buffer, so every rack takes several pages
+    std::array<cicero_move_record, 7> buf;
+    cicero_move_sink sink;
+    sink.moves = buf.data();
+    sink.cap = static_cast<int>(buf.size());
+
+    auto check_sink_agrees = [&]()
+    {
+        using generator = void (*)(const cicero*, cicero_rack);
+        using sink_generator = void (*)(const cicero*, cicero_rack, cicero_move_sink*);
+        const std::vector<std::pair<generator, sink_generator>> generators = {
+            { &cicero_generate_legal_moves, &cicero_generate_legal_moves_into },
+            { &cicero_generate_legal_moves_gaddag, &cicero_generate_legal_moves_gaddag_into },
+        };
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            for (const auto& [generate, generate_into] : generators) {
+                cb.clear_legal_moves();
+                generate(&engine, rack);
+                const auto expect = cb.sorted_legal_moves();
+
+                std::vector<scrabble::Move> actual;
+                sink.skip = 0;
+                do {
+                    generate_into(&engine, rack, &sink);
+                    CHECK(sink.total == static_cast<long>(expect.size()));
+                    for (int i = 0; i < sink.len; ++i) {
+                        actual.push_back(record_to_move(buf[static_cast<std::size_t>(i)]));
+                    }
+                    sink.skip += sink.len;
+                } while (sink.skip < sink.total);
+                std::sort(actual.begin(), actual.end());
+                CHECK(actual == expect);
+            }
+        }
+    };
+
+    for_each_position(&engine, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_sink_agrees();
+    });
+}
+
+TEST_CASE("Resumed move generation matches generating into a sink", "[sink]")
+{
+    auto cb = make_callbacks();
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+
+    const std::vector<std::string> racks = { "AEINRST", "EORSTU?", "??ABCDE", "E" };
+
+    std::vector<cicero_move_record> all(1 << 14);
+    cicero_move_sink sink;
+    sink.moves = all.data();
+    sink.cap = static_cast<int>(all.size());
+
+    auto check_resumed = [&]()
+    {
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            sink.skip = 0;
+            cicero_generate_legal_moves_into(&engine, rack, &sink);
+            REQUIRE(sink.len == sink.total);
+
+            for (int cap : { 1, 7, 64, sink.len + 1 }) {
+                INFO("cap = " << cap);
+                std::vector<cicero_move_record> buf(static_cast<std::size_t>(cap));
+                cicero_move_sink batch;
+                batch.moves = buf.data();
+                batch.cap = cap;
+                batch.skip = 0;
+                std::vector<cicero_move_record> resumed;
+                cicero_movegen gen;
+                cicero_movegen_start(&gen, &engine, rack);
+                int more;
+                do {
+                    more = cicero_movegen_resume(&gen, &batch);
+                    CHECK(batch.len == batch.total);
+                    CHECK(batch.len <= cap);
+                    CHECK((!more || batch.len == cap));
+                    resumed.insert(resumed.end(), buf.begin(), buf.begin() + batch.len);
+                } while (more);
+                REQUIRE(resumed.size() == static_cast<std::size_t>(sink.len));
+                for (std::size_t i = 0; i < resumed.size(); ++i) {
+                    CHECK(cicero_compare_move_records(&resumed[i], &all[i]) == 0);
+                    CHECK(resumed[i].score == all[i].score);
+                    CHECK(resumed[i].second == all[i].second);
+                }
+            }
+        }
+    };
+
+    for_each_position(&engine, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_resumed();
+    });
+}
+
+TEST_CASE("Each placement is generated once", "[gaddag]")
+{
+    // an S on J8 makes TRAMS and TAGS once TRAM is down
+    auto words = DICT;
+    for (const auto& word : { "TRAMS", "TAGS", "ZAGS", "BAMS", "AB", "BA", "AM", "MA", "AT", "TA" }) {
+        words.emplace_back(word);
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    auto cb = make_callbacks(words);
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+
+    const std::vector<std::string> racks = { "AEINRST", "EORSTU?", "??ABCDE" };
+
+    std::vector<cicero_move_record> buf(1 << 14);
+    cicero_move_sink sink;
+    sink.moves = buf.data();
+    sink.cap = static_cast<int>(buf.size());
+
+    auto occupied = [&engine](int sq) {
+        return 0 <= sq && sq < 225 && cicero_tile_on_square(&engine, sq) != CICERO_TILE_EMPTY;
+    };
+    int both_ways = 0;
+
+    auto check_placements = [&]()
+    {
+        using sink_generator = void (*)(const cicero*, cicero_rack, cicero_move_sink*);
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            for (sink_generator generate_into : { &cicero_generate_legal_moves_into, &cicero_generate_legal_moves_gaddag_into }) {
+                sink.skip = 0;
+                generate_into(&engine, rack, &sink);
+                REQUIRE(sink.len == sink.total);
+                std::set<std::string> placements;
+                for (int i = 0; i < sink.len; ++i) {
+                    const auto& rec = buf[static_cast<std::size_t>(i)];
+                    std::string placement;
+                    int tile_sq = -1;
+                    for (int k = 0; k < rec.length; ++k) {
+                        if (rec.tiles[k] != '.') {
+                            tile_sq = rec.square + k * rec.direction;
+                            const char tile = (rec.blanks & (1u << k)) != 0 ? static_cast<char>(tolower(rec.tiles[k])) : rec.tiles[k];
+                            placement += std::to_string(tile_sq) + tile;
+                        }
+                    }
+                    INFO("Placement " << placement);
+                    CHECK(placements.insert(placement).second);
+                    if (rec.ntiles != 1) {
+                        CHECK(rec.second == 0);
+                        continue;
+                    }
+                    // neighbors across must not wrap around to the next row
+                    const bool across = (tile_sq % 15 != 0 && occupied(tile_sq - 1)) || (tile_sq % 15 != 14 && occupied(tile_sq + 1));
+                    const bool down = occupied(tile_sq - 15) || occupied(tile_sq + 15);
+                    if (rec.direction == CICERO_HORZ) {
+                        CHECK(rec.second == (down ? CICERO_VERT : 0));
+                        both_ways += down ? 1 : 0;
+                    } else {
+                        CHECK(!across);
+                        CHECK(rec.second == 0);
+                    }
+                }
+            }
+        }
+    };
+
+    for_each_position(&engine, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_placements();
+    });
+    CHECK(both_ways > 0);
+}
+
+TEST_CASE("Blanks designated once a move is found")
+{
+    // words with the same letter more than once, so a blank has a choice of
+    // squares
+    auto words = DICT;
+    for (const auto& word : { "TAT", "TATS", "STAT", "STATS", "SAT", "SATS", "TAS", "TASS", "AS", "AT", "TA", "ZAGS", "BAMS", "TAGS", "TRAMS" }) {
+        words.emplace_back(word);
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    auto cb = make_callbacks(words);
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+
+    const std::vector<std::string> racks = { "AEINRST", "EORSTU?", "??ABCDE", "?EEINST", "??AAEIR", "?AASSTT", "?BEMOST" };
+
+    auto by_rank = [](const cicero_move_record& a, const cicero_move_record& b) { return cicero_compare_move_records(&a, &b) < 0; };
+    auto generate = [&](const std::string& tiles, int blanks)
+    {
+        std::vector<cicero_move_record> moves(1 << 15);
+        cicero_move_sink sink;
+        sink.moves = moves.data();
+        sink.cap = static_cast<int>(moves.size());
+        sink.skip = 0;
+        if (blanks < 0) {
+            cicero_generate_legal_moves_into(&engine, make_rack(tiles), &sink);
+        } else {
+            cicero_generate_legal_moves_blanks_into(&engine, make_rack(tiles), static_cast<cicero_blanks>(blanks), &sink);
+        }
+        REQUIRE(sink.len == sink.total);
+        moves.resize(static_cast<std::size_t>(sink.len));
+        std::sort(moves.begin(), moves.end(), by_rank);
+        return moves;
+    };
+    auto check_same = [](const std::vector<cicero_move_record>& a, const std::vector<cicero_move_record>& b)
+    {
+        REQUIRE(a.size() == b.size());
+        for (std::size_t i = 0; i < a.size(); ++i) {
+            CHECK(cicero_compare_move_records(&a[i], &b[i]) == 0);
+            CHECK(a[i].score == b[i].score);
+            CHECK(a[i].second == b[i].second);
+        }
+    };
+
+    auto check_blanks = [&]()
+    {
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            const auto all = generate(tiles, -1);
+            check_same(generate(tiles, CICERO_BLANKS_ALL), all);
+            // the best move of each placement, which comes first by rank
+            std::map<std::tuple<int, int, std::string>, cicero_move_record> best;
+            for (const auto& rec : all) {
+                best.emplace(std::make_tuple(rec.square, rec.direction, std::string{rec.tiles}), rec);
+            }
+            std::vector<cicero_move_record> expect;
+            for (const auto& placement : best) {
+                expect.push_back(placement.second);
+            }
+            std::sort(expect.begin(), expect.end(), by_rank);
+            check_same(generate(tiles, CICERO_BLANKS_BEST), expect);
+        }
+    };
+
+    for_each_position(&engine, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_blanks();
+    });
+}
+
+TEST_CASE("Move generation on one lexicon of a shared dictionary", "[gaddag]")
+{
+    // DICT is lexicon 1, lexicon 0 holds words that would add moves
+    const std::vector<std::string> other = { "ZA", "QI", "XU", "AE", "OE", "JO", "KI" };
+    const std::vector<WordList> lexicons = { WordList{other}, WordList{DICT} };
+    auto dawg = MafsaBuilder::build_lexicons(lexicons, MafsaType::eDawg);
+    auto gaddag = MafsaBuilder::build_lexicons(lexicons, MafsaType::eGaddag);
+    REQUIRE(dawg);
+    REQUIRE(gaddag);
+
+    auto cb = make_callbacks();
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+    cicero shared_engine;
+    auto shared_cb = cb.make_callbacks();
+    shared_cb.lexicon = dawg->lexicon(1);
+    shared_cb.gaddag = gaddag->lexicon(1);
+    cicero_init(&shared_engine, shared_cb);
+
+    const std::vector<std::string> racks = { "AEINRST", "EORSTU?", "QUIZ?AE" };
+
+    auto check_lexicons_agree = [&]()
+    {
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves(&engine, rack);
+            auto expect = cb.sorted_legal_moves();
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves(&shared_engine, rack);
+            CHECK(cb.sorted_legal_moves() == expect);
+            cb.clear_legal_moves();
+            cicero_generate_legal_moves_gaddag(&shared_engine, rack);
+            CHECK(cb.sorted_legal_moves() == expect);
+        }
+    };
+
+    for_each_position({ &engine, &shared_engine }, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_lexicons_agree();
+    });
+}
+
+TEST_CASE("Top-k moves are the best of all the moves")
+{
+    auto cb = make_callbacks();
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+
+    // clang-format off
+    const std::vector<std::string> racks = {
+        "AEINRST",
+        "EORSTU?",
+        "QUIZ?AE",
+        "??ABCDE",
+        "LLAMOSS",
+        "E",
+    };
+    // clang-format on
+
+    std::vector<cicero_move_record> all(1 << 14);
+    cicero_move_sink sink;
+    sink.moves = all.data();
+    sink.cap = static_cast<int>(all.size());
+
+    auto check_top_k = [&]()
+    {
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            sink.skip = 0;
+            cicero_generate_legal_moves_into(&engine, rack, &sink);
+            REQUIRE(sink.len == sink.total);
+            auto expect = std::vector<cicero_move_record>(all.begin(), all.begin() + sink.len);
+            std::sort(expect.begin(), expect.end(), [](const auto& a, const auto& b) {
+                return cicero_compare_move_records(&a, &b) < 0;
+            });
+
+            for (int k : { 1, 2, 10, 50, sink.len, sink.len + 3 }) {
+                INFO("k = " << k);
+                std::vector<cicero_move_record> top(static_cast<std::size_t>(std::max(k, 1)));
+                const int n = cicero_find_top_k(&engine, rack, top.data(), k);
+                REQUIRE(n == std::min(k, sink.len));
+                for (int i = 0; i < n; ++i) {
+                    const auto& a = top[static_cast<std::size_t>(i)];
+                    const auto& b = expect[static_cast<std::size_t>(i)];
+                    CHECK(cicero_compare_move_records(&a, &b) == 0);
+                    CHECK(a.score == b.score);
+                }
+            }
+        }
+    };
+
+    for_each_position(&engine, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_top_k();
+    });
+}
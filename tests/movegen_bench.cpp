@@ -0,0 +1,196 @@
+// Times move generation over saved positions (see example-games/positions):
+// every legal move into a sink, by the recursive generator and by the
+// resumable one (cicero_movegen) in one go or 64 moves at a time, the same
+// with only the best designation of the blanks, the best few moves against
+// sorting every legal move, and every legal move on a MoveGenPool of a few
+// sizes. With a GADDAG, every legal move is also timed with
+// cicero_generate_legal_moves_gaddag_into. Each is the best of a few passes
+// over all the positions.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <fmt/format.h>
+
+#include <mafsa++.h>
+#include <movegen_pool.h>
+#include <scrabble.h>
+
+#include "test_helpers.h"
+
+
+template <class F>
+static double time_ms(int reps, F&& f)
+{
+    using clock = std::chrono::steady_clock;
+    auto best = std::chrono::duration<double, std::milli>::max();
+    for (int i = 0; i < reps; ++i) {
+        const auto start = clock::now();
+        f();
+        best = std::min<std::chrono::duration<double, std::milli>>(best, clock::now() - start);
+    }
+    return best.count();
+}
+
+int main(int argc, char** argv)
+{
+    int first = 1;
+    const char* gaddag_path = nullptr;
+    if (argc > 2 && std::string_view{argv[1]} == "--gaddag") {
+        gaddag_path = argv[2];
+        first = 3;
+    }
+    if (argc < first + 2) {
+        std::cerr << "Usage: " << argv[0] << " [--gaddag GADDAG] [DICT] [POSITION]..." << std::endl;
+        return 1;
+    }
+    const int reps = 10;
+
+    auto maybe_dict = Mafsa::load(argv[first]);
+    if (!maybe_dict) {
+        std::cerr << "error: unable to load dictionary: " << argv[first] << std::endl;
+        return 1;
+    }
+    auto maybe_gaddag = gaddag_path ? Mafsa::load(gaddag_path, MafsaType::eGaddag) : std::optional<Mafsa>{};
+    if (gaddag_path && !maybe_gaddag) {
+        std::cerr << "error: unable to load GADDAG: " << gaddag_path << std::endl;
+        return 1;
+    }
+    Callbacks cb = maybe_gaddag ? Callbacks{std::move(*maybe_dict), std::move(*maybe_gaddag)} : Callbacks{std::move(*maybe_dict)};
+
+    std::vector<cicero>      engines;
+    std::vector<cicero_rack> racks;
+    for (int i = first + 1; i < argc; ++i) {
+        auto position = scrabble::read_board(argv[i]);
+        if (!position) {
+            std::cerr << "warning: skipping unreadable position: " << argv[i] << std::endl;
+            continue;
+        }
+        engines.emplace_back();
+        cicero_init(&engines.back(), cb.make_callbacks());
+        cicero_load_position(&engines.back(), position->board.data());
+        racks.emplace_back();
+        cicero_make_rack(&racks.back(), position->rack.c_str());
+    }
+
+    std::vector<cicero_move_record> moves(1 << 16);
+    cicero_move_sink sink;
+    sink.moves = moves.data();
+    sink.cap   = static_cast<int>(moves.size());
+
+    long nall = 0, nbest = 0, nsorted = 0;
+    const double all_ms = time_ms(reps, [&]() {
+        nall = 0;
+        for (std::size_t i = 0; i < engines.size(); ++i) {
+            sink.skip = 0;
+            cicero_generate_legal_moves_into(&engines[i], racks[i], &sink);
+            nall += sink.total;
+        }
+    });
+    long nstack = 0, npaged = 0;
+    const double stack_ms = time_ms(reps, [&]() {
+        nstack = 0;
+        for (std::size_t i = 0; i < engines.size(); ++i) {
+            cicero_movegen gen;
+            cicero_movegen_start(&gen, &engines[i], racks[i]);
+            while (cicero_movegen_resume(&gen, &sink)) {
+                nstack += sink.len;
+            }
+            nstack += sink.len;
+        }
+    });
+    cicero_move_sink page = sink;
+    page.cap = 64;
+    const double paged_ms = time_ms(reps, [&]() {
+        npaged = 0;
+        for (std::size_t i = 0; i < engines.size(); ++i) {
+            cicero_movegen gen;
+            cicero_movegen_start(&gen, &engines[i], racks[i]);
+            while (cicero_movegen_resume(&gen, &page)) {
+                npaged += page.len;
+            }
+            npaged += page.len;
+        }
+    });
+    long ngaddag = 0;
+    const double gaddag_ms = !gaddag_path ? 0 : time_ms(reps, [&]() {
+        ngaddag = 0;
+        for (std::size_t i = 0; i < engines.size(); ++i) {
+            sink.skip = 0;
+            cicero_generate_legal_moves_gaddag_into(&engines[i], racks[i], &sink);
+            ngaddag += sink.total;
+        }
+    });
+    const double best_ms = time_ms(reps, [&]() {
+        nbest = 0;
+        for (std::size_t i = 0; i < engines.size(); ++i) {
+            sink.skip = 0;
+            cicero_generate_legal_moves_blanks_into(&engines[i], racks[i], CICERO_BLANKS_BEST, &sink);
+            nbest += sink.total;
+        }
+    });
+    const double sorted_ms = time_ms(reps, [&]() {
+        nsorted = 0;
+        for (std::size_t i = 0; i < engines.size(); ++i) {
+            sink.skip = 0;
+            cicero_generate_legal_moves_into(&engines[i], racks[i], &sink);
+            std::sort(moves.begin(), moves.begin() + sink.len, [](const auto& a, const auto& b) {
+                return cicero_compare_move_records(&a, &b) < 0;
+            });
+            nsorted += sink.len;
+        }
+    });
+    std::vector<std::pair<int, long>> ntop;
+    std::vector<double>               top_ms;
+    for (int k : { 1, 10, 100 }) {
+        long n = 0;
+        top_ms.push_back(time_ms(reps, [&]() {
+            n = 0;
+            for (std::size_t i = 0; i < engines.size(); ++i) {
+                n += cicero_find_top_k(&engines[i], racks[i], moves.data(), k);
+            }
+        }));
+        ntop.emplace_back(k, n);
+    }
+
+    std::vector<std::pair<int, double>> pool_ms;
+    for (int threads : { 1, 2, 4, 8 }) {
+        MoveGenPool pool{threads};
+        long npool = 0;
+        pool_ms.emplace_back(threads, time_ms(reps, [&]() {
+            npool = 0;
+            for (std::size_t i = 0; i < engines.size(); ++i) {
+                npool += static_cast<long>(pool.generate(&engines[i], racks[i]).size());
+            }
+        }));
+        if (npool != nall) {
+            std::cerr << "error: pool of " << threads << " generated " << npool << " moves, expected " << nall << std::endl;
+            return 1;
+        }
+    }
+
+    fmt::print("positions: {}, hardware threads: {}\n", engines.size(), std::thread::hardware_concurrency());
+    fmt::print("{:<14} {:>10} {:>10}\n", "generation", "moves", "time (ms)");
+    fmt::print("{:<14} {:>10} {:>10.2f}\n", "all", nall, all_ms);
+    fmt::print("{:<14} {:>10} {:>10.2f}  ({:.2f}x)\n", "all, resumed", nstack, stack_ms, all_ms / stack_ms);
+    fmt::print("{:<14} {:>10} {:>10.2f}  ({:.2f}x)\n", "all, by 64", npaged, paged_ms, all_ms / paged_ms);
+    if (gaddag_path) {
+        fmt::print("{:<14} {:>10} {:>10.2f}  ({:.2f}x)\n", "all, gaddag", ngaddag, gaddag_ms, all_ms / gaddag_ms);
+    }
+    fmt::print("{:<14} {:>10} {:>10.2f}\n", "best blanks", nbest, best_ms);
+    fmt::print("{:<14} {:>10} {:>10.2f}\n", "all, sorted", nsorted, sorted_ms);
+    for (std::size_t i = 0; i < ntop.size(); ++i) {
+        fmt::print("{:<14} {:>10} {:>10.2f}\n", fmt::format("top {}", ntop[i].first), ntop[i].second, top_ms[i]);
+    }
+    for (const auto& [threads, ms] : pool_ms) {
+        fmt::print("{:<14} {:>10} {:>10.2f}\n", fmt::format("pool x{}", threads), nall, ms);
+    }
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <catch2/catch.hpp>
+#include <deque>
+#include <movegen_pool.h>
+#include "test_helpers.h"
+
+TEST_CASE("Move generation on a thread pool matches one thread")
+{
+    auto cb = make_callbacks();
+    cicero engine;
+    cicero_init(&engine, cb.make_callbacks());
+
+    // clang-format off
+    const std::vector<std::string> racks = {
+        "AEINRST",
+        "EORSTU?",
+        "QUIZ?AE",
+        "??ABCDE",
+        "",
+    };
+    // clang-format on
+
+    std::deque<MoveGenPool> pools;
+    for (int threads : { 0, 1, 3, 8 }) {
+        pools.emplace_back(threads);
+    }
+    CHECK(pools[0].threads() == 1);
+    CHECK(pools[3].threads() == 8);
+
+    std::vector<cicero_move_record> all(1 << 14);
+    cicero_move_sink sink;
+    sink.moves = all.data();
+    sink.cap = static_cast<int>(all.size());
+
+    auto check_pools = [&]()
+    {
+        for (const auto& tiles : racks) {
+            INFO("Rack " << tiles);
+            auto rack = make_rack(tiles);
+            sink.skip = 0;
+            cicero_generate_legal_moves_into(&engine, rack, &sink);
+            REQUIRE(sink.len == sink.total);
+            for (auto& pool : pools) {
+                INFO("Threads " << pool.threads());
+                const auto& moves = pool.generate(&engine, rack);
+                REQUIRE(moves.size() == static_cast<std::size_t>(sink.len));
+                for (std::size_t i = 0; i < moves.size(); ++i) {
+                    CHECK(cicero_compare_move_records(&moves[i], &all[i]) == 0);
+                    CHECK(moves[i].score == all[i].score);
+                }
+            }
+        }
+    };
+
+    for_each_position(&engine, ISC_MOVES, [&](const std::string& after) {
+        INFO("After " << after);
+        check_pools();
+    });
+}
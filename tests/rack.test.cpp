@@ -0,0 +1,46 @@
+#include <catch2/catch.hpp>
+#include <algorithm>
+#include <cstring>
+#include <scrabble.h>
+#include "test_helpers.h"
+
+TEST_CASE("Packed racks match cicero racks")
+{
+    static_assert(scrabble::rack_count(scrabble::pack_rack("AAB?"), 'A') == 2);
+    static_assert(scrabble::rack_count(scrabble::pack_rack("AAB?"), CICERO_TILE_BLANK) == 1);
+    static_assert(scrabble::pack_rack("QZ  ").mask == ((1u << 16) | (1u << 25)));
+    static_assert(scrabble::rack_count(scrabble::pack_rack("AAAAAAAAAAAAAAAAB"), 'A') == 15);
+    static_assert(scrabble::rack_count(scrabble::pack_rack("AAAAAAAAAAAAAAAAB"), 'B') == 1);
+
+    for (const std::string tiles : { "", "AEINRST", "EORSTU?", "??ABCDE", "QUIZ?AE", "ZZZZZZZZZZZZZZZ", "PQRS" }) {
+        INFO("Rack " << tiles);
+        const auto rack = make_rack(tiles);
+        const auto packed = cicero_pack_rack(&rack);
+        const auto expect = scrabble::pack_rack(tiles);
+        CHECK(packed.counts[0] == expect.counts[0]);
+        CHECK(packed.counts[1] == expect.counts[1]);
+        CHECK(packed.mask == expect.mask);
+        for (int i = 0; i < 27; ++i) {
+            CHECK(((packed.mask >> i) & 1u) == (rack.tiles[i] > 0 ? 1u : 0u));
+        }
+
+        cicero_rack unpacked;
+        cicero_unpack_rack(&unpacked, &packed);
+        CHECK(memcmp(unpacked.tiles, rack.tiles, sizeof(rack.tiles)) == 0);
+        auto sorted = tiles;
+        std::sort(sorted.begin(), sorted.end(), [](char a, char b) {
+            return (a == CICERO_TILE_BLANK ? 'Z' + 1 : a) < (b == CICERO_TILE_BLANK ? 'Z' + 1 : b);
+        });
+        CHECK(scrabble::unpack_rack(packed) == sorted);
+    }
+
+    // too many of a tile saturate instead of carrying into the next one
+    const std::string tiles = "AAAAAAAAAAAAAAAAAAAB";
+    const auto rack = make_rack(tiles);
+    const auto packed = cicero_pack_rack(&rack);
+    const auto expect = scrabble::pack_rack(tiles);
+    CHECK(packed.counts[0] == expect.counts[0]);
+    CHECK(packed.mask == expect.mask);
+    CHECK(scrabble::rack_count(packed, 'A') == 15);
+    CHECK(scrabble::rack_count(packed, 'B') == 1);
+}
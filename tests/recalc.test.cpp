@@ -188,3 +188,103 @@ TEST_CASE("Rebuild state after H8 APPLE")
         }
     }
 }
+
+// cross-checks of every empty square next to a tile, straight from the word list
+static void check_xchks(const cicero& engine, const Callbacks& cb)
+{
+    auto letter = [&engine](int sq) { return static_cast<char>(toupper(cicero_tile_on_square(&engine, sq))); };
+    for (int sq = 0; sq < 225; ++sq) {
+        if (cicero_tile_on_square(&engine, sq) != CICERO_TILE_EMPTY) {
+            continue;
+        }
+        const int row = sq / 15;
+        const int col = sq % 15;
+        for (int stride : { 1, 15 }) {
+            const int pos  = stride == 1 ? col : row;
+            std::string before, after;
+            for (int p = pos - 1; p >= 0 && letter(sq - (pos - p) * stride) != CICERO_TILE_EMPTY; --p) {
+                before.insert(before.begin(), letter(sq - (pos - p) * stride));
+            }
+            for (int p = pos + 1; p < 15 && letter(sq + (p - pos) * stride) != CICERO_TILE_EMPTY; ++p) {
+                after += letter(sq + (p - pos) * stride);
+            }
+            if (before.empty() && after.empty()) {
+                continue;
+            }
+            std::uint32_t expect = 0;
+            for (char c = 'A'; c <= 'Z'; ++c) {
+                if (cb.isword(before + c + after)) {
+                    expect |= 1u << (c - 'A');
+                }
+            }
+            // vchk is for playing along a row, so it is formed down the column
+            const std::uint32_t actual = stride == 1 ? engine.vchk[sq] : engine.hchk[sq];
+            INFO("Checking " << hume::Square::make(sq)->name() << " " << before << "." << after);
+            INFO("Expected " << XChk{expect} << ", got " << XChk{actual});
+            CHECK(actual == expect);
+        }
+    }
+}
+
+// the transposed board has to match the board, see cicero::tvals
+static void check_transposed(const cicero& engine)
+{
+    for (int sq = 0; sq < 225; ++sq) {
+        INFO("Checking " << hume::Square::make(sq)->name());
+        const int tsq = (sq % 15) * 15 + sq / 15;
+        CHECK(engine.tvals[tsq] == engine.vals[sq]);
+        CHECK(engine.tvscr[tsq] == engine.vscr[sq]);
+        CHECK(engine.tvchk[tsq] == engine.vchk[sq]);
+    }
+}
+
+TEST_CASE("Cross-checks stay correct as runs are extended and undone")
+{
+    // the played words and the words they can be extended to
+    auto words = DICT;
+    for (const auto& word : {
+            "ZAG", "ZAGS", "BAM", "BAMS", "TAG", "TAGS", "STAG", "TRAM", "TRAMS", "OD", "ODS", "GOD", "ODE",
+            "ARENITE", "ARENITES", "PEDANTS", "YO", "YOB", "YOD", "JIB", "JIBS", "TOECLIP", "TOECLIPS",
+            "OHS", "QAT", "QATS", "AB", "BA", "TA", "AT", "IT", "TI", "MA", "AM", "ZA", "QI", "OE", "OX" }) {
+        words.emplace_back(word);
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    auto cb = make_callbacks(words);
+
+    // with a GADDAG the squares in front of runs carry on from the run's
+    // backward state, without one they are walked
+    for (bool gaddag : { true, false }) {
+        INFO("GADDAG " << gaddag);
+        auto callbacks = cb.make_callbacks();
+        if (!gaddag) {
+            memset(&callbacks.gaddag, 0, sizeof(callbacks.gaddag));
+        }
+        cicero engine;
+        cicero_init(&engine, callbacks);
+        for (const auto& isc_move : ISC_MOVES) {
+            INFO("After " << isc_move);
+            auto smove = scrabble::Move::from_isc_spec(isc_move.c_str());
+            auto emove = scrabble::EngineMove::make(&engine, smove);
+            const cicero copy = engine;
+            cicero_savepos sp;
+            cicero_make_move(&engine, &sp, &emove.move);
+            cicero_undo_move(&engine, &sp, &emove.move);
+            CHECK(memcmp(copy.hfwd, engine.hfwd, sizeof(copy.hfwd)) == 0);
+            CHECK(memcmp(copy.vfwd, engine.vfwd, sizeof(copy.vfwd)) == 0);
+            CHECK(memcmp(copy.hrev, engine.hrev, sizeof(copy.hrev)) == 0);
+            CHECK(memcmp(copy.vrev, engine.vrev, sizeof(copy.vrev)) == 0);
+            check_transposed(engine);
+            cicero_make_move(&engine, &sp, &emove.move);
+            check_xchks(engine, cb);
+            check_transposed(engine);
+        }
+
+        char board[225];
+        copy_position(engine, board);
+        cicero loaded;
+        cicero_init(&loaded, callbacks);
+        cicero_load_position(&loaded, board);
+        check_transposed(loaded);
+    }
+}
@@ -252,3 +252,60 @@ Rack: "AEHIOPX"
     int score = cicero_make_move(&engine, &sp, &cmove);
     CHECK(score == 19);
 }
+
+TEST_CASE("Generated moves are scored as if played", "[score]")
+{
+    // the played words, some of their hooks and a few bingos
+    auto words = DICT;
+    for (const auto& word : {
+            "ZAG", "ZAGS", "BAM", "BAMS", "TAG", "TAGS", "STAG", "TRAM", "TRAMS", "OD", "ODS",
+            "ARENITE", "PEDANTS", "YO", "YOB", "QAT", "QATS", "RETAINS", "NASTIER", "STAINER",
+            "RETINAS", "ROUTES", "OUTERS", "TOUSER", "AB", "BA", "TA", "AT", "MA", "AM", "ZA" }) {
+        words.emplace_back(word);
+    }
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+    auto cb = make_callbacks(words);
+
+    // clang-format off
+    const std::vector<std::string> racks = {
+        "AEINRST",
+        "EORSTU?",
+        "QUIZ?AE",
+        "??ABCDE",
+    };
+    // clang-format on
+
+    using init_fn = void (*)(cicero*, cicero_callbacks);
+    for (init_fn init : { &cicero_init, &cicero_init_wwf }) {
+        cicero_savepos sp;
+        cicero engine;
+        init(&engine, cb.make_callbacks());
+        int bingos = 0;
+
+        auto check_scores = [&]()
+        {
+            using generator = void (*)(const cicero*, cicero_rack);
+            for (generator generate : { &cicero_generate_legal_moves, &cicero_generate_legal_moves_gaddag }) {
+                for (const auto& tiles : racks) {
+                    INFO("Rack " << tiles);
+                    cb.clear_legal_moves();
+                    generate(&engine, make_rack(tiles));
+                    for (const auto& move : cb.sorted_legal_moves()) {
+                        INFO("Move " << move);
+                        auto emove = scrabble::EngineMove::make(&engine, move);
+                        CHECK(move.score == cicero_make_move(&engine, &sp, &emove.move));
+                        cicero_undo_move(&engine, &sp, &emove.move);
+                        bingos += emove.move.ntiles == 7 ? 1 : 0;
+                    }
+                }
+            }
+        };
+
+        for_each_position(&engine, ISC_MOVES, [&](const std::string& after) {
+            INFO("After " << after);
+            check_scores();
+        });
+        CHECK(bingos > 0);
+    }
+}
@@ -1,5 +1,8 @@
 #pragma once
 #include <vector>
+#include <initializer_list>
+#include <string>
+#include <utility>
 #include <unordered_set>
 #include <algorithm>
 #include <iostream>
@@ -13,7 +16,9 @@ struct Callbacks
 {
     using Move = scrabble::Move;
 
-    Callbacks(Mafsa&& m) noexcept : mafsa_{std::move(m)}, legal_moves_{} {}
+    Callbacks(Mafsa&& m) noexcept : mafsa_{std::move(m)}, gaddag_{}, legal_moves_{} {}
+    Callbacks(Mafsa&& m, Mafsa&& gaddag) noexcept
+        : mafsa_{std::move(m)}, gaddag_{std::move(gaddag)}, legal_moves_{} {}
 
     static cicero_edges prefix_edges(void* data, const char* prefix) noexcept
     {
@@ -21,10 +26,10 @@ struct Callbacks
         return self->prefix_edges_(prefix);
     }
 
-    static void on_legal_move(void* data, const char* word, int square, int direction) noexcept
+    static void on_legal_move(void* data, const char* word, int square, int direction, int score) noexcept
     {
         auto* self = reinterpret_cast<Callbacks*>(data);
-        return self->on_legal_move_(word, square, direction);
+        return self->on_legal_move_(word, square, direction, score);
     }
 
     void clear_legal_moves() noexcept
@@ -46,6 +51,17 @@ struct Callbacks
         cb.getedges = &Callbacks::prefix_edges;
         cb.onlegaldata = this;
         cb.getedgesdata = this;
+        cb.lexicon = mafsa_.lexicon();
+        if (gaddag_) {
+            cb.gaddag = gaddag_->lexicon();
+        } else {
+            memset(&cb.gaddag, 0, sizeof(cb.gaddag));
+        }
+        cb.hooks = nullptr;
+        cb.hooksdata = nullptr;
+        cb.xchklookup = nullptr;
+        cb.xchkstore = nullptr;
+        cb.xchkdata = nullptr;
         return cb;
     }
 
@@ -64,29 +80,35 @@ private:
         return out;
     }
 
-    void on_legal_move_(const char* word, int square, int direction)
+    void on_legal_move_(const char* word, int square, int direction, int score)
     {
         legal_moves_.emplace_back();
         legal_moves_.back().square = scrabble::Square{square};
         legal_moves_.back().direction = static_cast<scrabble::Direction>(direction);
         legal_moves_.back().word = word;
-        legal_moves_.back().score = -1;
+        legal_moves_.back().score = score;
     }
 
-    Mafsa             mafsa_;
-    std::vector<Move> legal_moves_;
+    Mafsa                mafsa_;
+    std::optional<Mafsa> gaddag_;
+    std::vector<Move>    legal_moves_;
 };
 
 inline Callbacks make_callbacks(const std::vector<std::string>& words = DICT)
 {
     MafsaBuilder builder;
+    MafsaBuilder gaddag_builder;
     for (const auto& word : words) {
         bool ok = builder.insert(word);
         assert(ok == true);
+        ok = gaddag_builder.insert_gaddag(word);
+        assert(ok == true);
     }
     auto maybe_mafsa = builder.finish();
     assert(static_cast<bool>(maybe_mafsa) == true);
-    return Callbacks(std::move(*maybe_mafsa));
+    auto maybe_gaddag = gaddag_builder.finish();
+    assert(static_cast<bool>(maybe_gaddag) == true);
+    return Callbacks(std::move(*maybe_mafsa), std::move(*maybe_gaddag));
 }
 
 inline cicero_rack make_rack(std::string tiles)
@@ -109,6 +131,49 @@ inline std::vector<scrabble::Move> make_move_list(const std::vector<std::string>
     return result;
 }
 
+// A game the move generation tests play through: hooks, parallel plays, a
+// word made longer at either end and a blank
+// clang-format off
+const std::vector<std::string> ISC_MOVES = {
+    "H7  zag     26",
+    "I6  bam     24",
+    "J5  tag     25",
+    "8F  tram     6",
+    "K5  od      16",
+    "L4  arenite 76",
+    "10B pEdants 81",
+    "9C  yo      20",
+    "8K  jib     12",
+    "N6  toeclip 78",
+    "O6  ohs     67",
+    "F6  qat     32",
+};
+// clang-format on
+
+// Calls `fn` with "" on the position `engines` start from, which must be the
+// same for all of them, and then with each of `isc_moves` once it has been
+// played on all of them.
+template <typename Fn>
+void for_each_position(std::initializer_list<cicero*> engines, const std::vector<std::string>& isc_moves, Fn&& fn)
+{
+    fn(std::string{});
+    cicero_savepos sp;
+    for (const auto& isc_move : isc_moves) {
+        auto move = scrabble::Move::from_isc_spec(isc_move);
+        auto emove = scrabble::EngineMove::make(*engines.begin(), move);
+        for (cicero* engine : engines) {
+            cicero_make_move(engine, &sp, &emove.move);
+        }
+        fn(isc_move);
+    }
+}
+
+template <typename Fn>
+void for_each_position(cicero* engine, const std::vector<std::string>& isc_moves, Fn&& fn)
+{
+    for_each_position({ engine }, isc_moves, std::forward<Fn>(fn));
+}
+
 inline std::ostream& operator<<(std::ostream& os, const cicero& engine)
 {
     auto print_row = [&os](const cicero& e, int row) {
@@ -0,0 +1,80 @@
+#include <catch2/catch.hpp>
+#include <filesystem>
+#include <fstream>
+#include <zlib.h>
+#include <wordlist.h>
+
+static const char* const WORDLIST_CONTENTS =
+    "aa\n"
+    "Ab\r\n"
+    "\n"
+    "  zyzzyva  \n"
+    "x\n"
+    "cant't\n"
+    "ABCDEFGHIJKLMNOP\n"
+    "\t\r\n"
+    "qi";
+
+static std::vector<std::string> all_words(const WordList& words)
+{
+    std::vector<std::string> result;
+    for (std::size_t i = 0; i < words.size(); ++i) {
+        result.emplace_back(words.view(i));
+        CHECK(std::string{words[i]} == result.back());
+    }
+    return result;
+}
+
+TEST_CASE("Read word list")
+{
+    const auto dir = std::filesystem::temp_directory_path();
+    const auto txt = (dir / "cicero-wordlist-test.txt").string();
+    const auto gz  = (dir / "cicero-wordlist-test.txt.gz").string();
+    {
+        std::ofstream ofs{txt, std::ios::binary};
+        ofs << WORDLIST_CONTENTS;
+    }
+    {
+        gzFile file = gzopen(gz.c_str(), "wb");
+        REQUIRE(file != nullptr);
+        gzputs(file, WORDLIST_CONTENTS);
+        gzclose(file);
+    }
+    const std::vector<std::string> expect = { "AA", "AB", "ZYZZYVA", "QI" };
+
+    for (const auto& path : { txt, gz }) {
+        INFO("Reading " << path);
+        WordListSummary summary;
+
+        SECTION("All words")
+        {
+            auto words = WordList::read(path, INT_MAX, summary);
+            REQUIRE(words);
+            CHECK(all_words(*words) == expect);
+            CHECK(summary.lines == 7);
+            CHECK(summary.bad_length == 2);
+            CHECK(summary.bad_letters == 1);
+            REQUIRE(summary.examples.size() == 3);
+            CHECK(summary.examples[0].first == 5);
+            CHECK(summary.examples[0].second == "X");
+            CHECK(summary.examples[1].first == 6);
+            CHECK(summary.examples[1].second == "CANT'T");
+        }
+
+        SECTION("Limited number of words")
+        {
+            auto words = WordList::read(path, 3, summary);
+            REQUIRE(words);
+            CHECK(all_words(*words) == std::vector<std::string>{ "AA", "AB", "ZYZZYVA" });
+        }
+    }
+
+    std::filesystem::remove(txt);
+    std::filesystem::remove(gz);
+}
+
+TEST_CASE("Read missing word list")
+{
+    WordListSummary summary;
+    CHECK(!WordList::read("/nonexistent/cicero-wordlist.txt", INT_MAX, summary));
+}
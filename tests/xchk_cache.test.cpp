@@ -0,0 +1,139 @@
+#include <catch2/catch.hpp>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <xchk_cache.h>
+#include "test_helpers.h"
+
+// any value that depends on the whole fragment
+static std::uint32_t fake_xchk(const std::string& frag)
+{
+    std::uint32_t result = static_cast<std::uint32_t>(frag.size());
+    for (char c : frag) {
+        result = result * 31u + static_cast<unsigned char>(c);
+    }
+    return result & ((1u << 26) - 1);
+}
+
+static std::string make_frag(unsigned int n)
+{
+    std::string result;
+    do {
+        result += static_cast<char>('A' + n % 26);
+        n /= 26;
+    } while (n != 0);
+    result.insert(result.size() / 2, 1, '.');
+    return result;
+}
+
+TEST_CASE("Cross-check cache lookup and store")
+{
+    XChkCache cache{100};
+    CHECK(cache.capacity() == 128);
+
+    std::uint32_t xchk = 0;
+    CHECK(!cache.lookup("AB.", 3, xchk));
+    cache.store("AB.", 3, 42u);
+    REQUIRE(cache.lookup("AB.", 3, xchk));
+    CHECK(xchk == 42u);
+    CHECK(!cache.lookup("AB", 2, xchk));
+    CHECK(!cache.lookup(".AB", 3, xchk));
+    CHECK(cache.stats().hits == 1);
+    CHECK(cache.stats().misses == 3);
+
+    // far more fragments than slots: colliding fragments must not be
+    // mistaken for each other
+    for (unsigned int n = 0; n < 10000; ++n) {
+        const auto frag = make_frag(n);
+        cache.store(frag.c_str(), static_cast<int>(frag.size()), fake_xchk(frag));
+    }
+    int hits = 0;
+    for (unsigned int n = 0; n < 10000; ++n) {
+        const auto frag = make_frag(n);
+        if (cache.lookup(frag.c_str(), static_cast<int>(frag.size()), xchk)) {
+            INFO("Fragment " << frag);
+            CHECK(xchk == fake_xchk(frag));
+            ++hits;
+        }
+    }
+    CHECK(hits > 0);
+    CHECK(hits <= 128);
+
+    cache.clear();
+    CHECK(cache.stats().hits == 0);
+    CHECK(cache.stats().misses == 0);
+    CHECK(!cache.lookup("AB.", 3, xchk));
+}
+
+TEST_CASE("Cross-check cache shared between threads")
+{
+    XChkCache cache{1024};
+    constexpr int kThreads = 4;
+    constexpr unsigned int kFrags = 5000;
+    std::vector<int> wrong(kThreads, 0);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&cache, &wrong, t]() {
+            for (unsigned int i = 0; i < 4 * kFrags; ++i) {
+                const auto frag = make_frag((i * 7919u + static_cast<unsigned int>(t) * 104729u) % kFrags);
+                const int len = static_cast<int>(frag.size());
+                std::uint32_t xchk;
+                if (cache.lookup(frag.c_str(), len, xchk)) {
+                    wrong[static_cast<std::size_t>(t)] += xchk != fake_xchk(frag) ? 1 : 0;
+                } else {
+                    cache.store(frag.c_str(), len, fake_xchk(frag));
+                }
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    for (int t = 0; t < kThreads; ++t) {
+        CHECK(wrong[static_cast<std::size_t>(t)] == 0);
+    }
+    const auto stats = cache.stats();
+    CHECK(stats.hits + stats.misses == kThreads * 4 * kFrags);
+    CHECK(stats.hits > 0);
+}
+
+TEST_CASE("Move generation with cross-check cache matches without")
+{
+    auto cb = make_callbacks();
+    XChkCache cache{4096};
+    auto cache_cb = cb.make_callbacks();
+    cache_cb.xchklookup = &XChkCache::cicero_lookup;
+    cache_cb.xchkstore = &XChkCache::cicero_store;
+    cache_cb.xchkdata = &cache;
+
+    // the second game finds the first one's cross-checks in the cache
+    for (int game = 0; game < 2; ++game) {
+        INFO("Game " << game);
+        cicero engine;
+        cicero_init(&engine, cb.make_callbacks());
+        cicero cache_engine;
+        cicero_init(&cache_engine, cache_cb);
+        for_each_position({ &engine, &cache_engine }, ISC_MOVES, [&](const std::string& after) {
+            INFO("After " << after);
+            CHECK(memcmp(engine.hchk, cache_engine.hchk, sizeof(engine.hchk)) == 0);
+            CHECK(memcmp(engine.vchk, cache_engine.vchk, sizeof(engine.vchk)) == 0);
+        });
+
+        const auto before = cache.stats();
+        char board[225];
+        for (int sq = 0; sq < 225; ++sq) {
+            board[sq] = cicero_tile_on_square(&engine, sq);
+        }
+        cicero loaded;
+        cicero_init(&loaded, cb.make_callbacks());
+        cicero_load_position(&loaded, board);
+        cicero cache_loaded;
+        cicero_init(&cache_loaded, cache_cb);
+        cicero_load_position(&cache_loaded, board);
+        CHECK(memcmp(loaded.hchk, cache_loaded.hchk, sizeof(loaded.hchk)) == 0);
+        CHECK(memcmp(loaded.vchk, cache_loaded.vchk, sizeof(loaded.vchk)) == 0);
+        // the position's cross-checks were all computed while playing it
+        CHECK(cache.stats().misses == before.misses);
+    }
+    CHECK(cache.stats().hits > cache.stats().misses);
+}
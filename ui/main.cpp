@@ -137,10 +137,10 @@ struct Callbacks
         return self->prefix_edges_(prefix);
     }
 
-    static void on_legal_move(void* data, const char* word, int square, int direction) noexcept
+    static void on_legal_move(void* data, const char* word, int square, int direction, int score) noexcept
     {
         auto* self = reinterpret_cast<Callbacks*>(data);
-        return self->on_legal_move_(word, square, direction);
+        return self->on_legal_move_(word, square, direction, score);
     }
 
     void clear_legal_moves() noexcept
@@ -162,6 +162,13 @@ struct Callbacks
         cb.getedges = &Callbacks::prefix_edges;
         cb.onlegaldata = this;
         cb.getedgesdata = this;
+        cb.lexicon = mafsa_.lexicon();
+        memset(&cb.gaddag, 0, sizeof(cb.gaddag));
+        cb.hooks = nullptr;
+        cb.hooksdata = nullptr;
+        cb.xchklookup = nullptr;
+        cb.xchkstore = nullptr;
+        cb.xchkdata = nullptr;
         return cb;
     }
 
@@ -180,13 +187,13 @@ private:
         return out;
     }
 
-    void on_legal_move_(const char* word, int square, int direction)
+    void on_legal_move_(const char* word, int square, int direction, int score)
     {
         legal_moves_.emplace_back();
         legal_moves_.back().square = scrabble::Square{square};
         legal_moves_.back().direction = static_cast<scrabble::Direction>(direction);
         legal_moves_.back().word = word;
-        legal_moves_.back().score = -1;
+        legal_moves_.back().score = score;
         DEBUG("Found legal move: {}", legal_moves_.back());
     }
 
@@ -629,13 +636,6 @@ int main(int argc, char** argv)
                 cicero_generate_legal_moves(&engine, erack);
                 DEBUG("Finished generating legal moves...");
                 auto moves = cb.sorted_legal_moves();
-                cicero_savepos sp;
-                for (auto& move : moves) {
-                    auto emove = scrabble::EngineMove::make(&engine, move);
-                    auto cmove = emove.move;
-                    move.score = cicero_make_move(&engine, &sp, &cmove);
-                    cicero_undo_move(&engine, &sp, &cmove);
-                }
                 std::sort(moves.begin(), moves.end(),
                         [](const auto& m1, const auto& m2) {
                             return m1.score > m2.score;
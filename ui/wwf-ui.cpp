@@ -42,10 +42,10 @@ struct Callbacks
         return self->prefix_edges_(prefix);
     }
 
-    static void on_legal_move(void* data, const char* word, int square, int direction) noexcept
+    static void on_legal_move(void* data, const char* word, int square, int direction, int score) noexcept
     {
         auto* self = reinterpret_cast<Callbacks*>(data);
-        return self->on_legal_move_(word, square, direction);
+        return self->on_legal_move_(word, square, direction, score);
     }
 
     void clear_legal_moves() noexcept
@@ -67,6 +67,13 @@ struct Callbacks
         cb.getedges = &Callbacks::prefix_edges;
         cb.onlegaldata = this;
         cb.getedgesdata = this;
+        cb.lexicon = mafsa_.lexicon();
+        memset(&cb.gaddag, 0, sizeof(cb.gaddag));
+        cb.hooks = nullptr;
+        cb.hooksdata = nullptr;
+        cb.xchklookup = nullptr;
+        cb.xchkstore = nullptr;
+        cb.xchkdata = nullptr;
         return cb;
     }
 
@@ -85,13 +92,13 @@ private:
         return out;
     }
 
-    void on_legal_move_(const char* word, int square, int direction)
+    void on_legal_move_(const char* word, int square, int direction, int score)
     {
         legal_moves_.emplace_back();
         legal_moves_.back().square = scrabble::Square{square};
         legal_moves_.back().direction = static_cast<scrabble::Direction>(direction);
         legal_moves_.back().word = word;
-        legal_moves_.back().score = -1;
+        legal_moves_.back().score = score;
         DEBUG("Found legal move: {}", legal_moves_.back());
     }
 